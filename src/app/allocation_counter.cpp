@@ -0,0 +1,63 @@
+/*
+ * File: allocation_counter.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+/*
+ * global operator new counting allocations for profiler; it is part
+ * of executables only, so that libtraveler leaves allocator of programs
+ * embedding it alone
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "profiler.hpp"
+
+// allocations are counted always, it costs a call and two increments
+void* operator new(
+                   std::size_t size)
+{
+    profiler::count_allocation(size);
+
+    if (size == 0)
+        size = 1;
+    void* p;
+    while ((p = malloc(size)) == nullptr)
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+    }
+    return p;
+}
+
+void operator delete(
+                     void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(
+                     void* p,
+                     std::size_t) noexcept
+{
+    free(p);
+}
@@ -20,22 +20,32 @@
  */
 
 
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <map>
+#include <thread>
+
 #include "app.hpp"
 #include "utils.hpp"
-#include "mapping.hpp"
-#include "tree_matcher.hpp"
-#include "extractor.hpp"
-#include "document_writer.hpp"
-#include "compact.hpp"
-#include "overlap_checks.hpp"
-#include "rted.hpp"
-#include "gted.hpp"
-#include "overlap_checks.hpp"
+#include "structure_reader.hpp"
+#include "traveler.hpp"
+#include "profiler.hpp"
+#include "job_context.hpp"
+#include "server.hpp"
 
 #define ARGS_HELP                           {"-h", "--help"}
 #define ARGS_TARGET_STRUCTURE               {"-gs", "--target-structure"}
 #define ARGS_TEMPLATE_STRUCTURE             {"-ts", "--template-structure"}
 #define ARGS_TEMPLATE_STRUCTURE_FILE_TYPE   "--file-format"
+#define ARGS_TEMPLATE_BUNDLE                {"-tb", "--template-bundle"}
+#define ARGS_COMPILE_TEMPLATE               "compile-template"
+#define ARGS_SERVE                          "serve"
+#define ARGS_SOCKET                         "--socket"
+#define ARGS_SERVE_TEMPLATE                 "--template"
+#define ARGS_TIMEOUT                        "--timeout"
+#define ARGS_BATCH                          {"-b", "--batch"}
+#define ARGS_THREADS                        "--threads"
 #define ARGS_ALL                            {"-a", "--all"}
 #define ARGS_ALL_OVERLAPS                   "--overlaps"
 #define ARGS_TED                            {"-t", "--ted"}
@@ -45,6 +55,12 @@
 #define ARGS_VERBOSE                        {"-v", "--verbose"}
 #define ARGS_DEBUG                          {"--debug"}
 #define ARGS_NUMBERING                       {"-n", "--numbering"}
+#define ARGS_LAYOUT_TIME_BUDGET             "--layout-time-budget"
+#define ARGS_LAYOUT_MAX_ITERATIONS          "--layout-max-iter"
+#define ARGS_COMPRESS                       "--compress"
+#define ARGS_BINARY_LAYOUT                  "--binary-layout"
+#define ARGS_PROFILE                        "--profile"
+#define ARGS_PROFILE_COUNTERS               "--profile-counters"
 
 #define COLORED_FILENAME_EXTENSION          ".colored"
 
@@ -52,12 +68,54 @@
 
 using namespace std;
 
+/**
+ * overlaps of one rna layout, computed on first request only
+ * and shared by every consumer afterwards
+ */
+class lazy_overlaps
+{
+public:
+    lazy_overlaps(
+                  rna_tree& _rna)
+    : rna(_rna)
+    { }
+    
+    /**
+     * runs overlap checks when called for the first time
+     */
+    const overlap_checks::overlaps& get()
+    {
+        if (!computed)
+        {
+            value = traveler::find_overlaps(rna);
+            computed = true;
+        }
+        return value;
+    }
+    
+    inline bool is_computed() const
+    {
+        return computed;
+    }
+    
+private:
+    rna_tree& rna;
+    overlap_checks::overlaps value;
+    bool computed = false;
+};
+
 
 struct app::arguments
 {
     rna_tree templated; // template
-    rna_tree matched; // target
+    std::string targets; // file with target structures
+    std::string batch; // batch manifest
+    size_t threads = 0;
     bool rotate_branches = false;
+    bool compress = false;
+    bool binary_layout = false;
+    std::string profile; // profile report file
+    bool profile_counters = false;
     
     struct
     {
@@ -82,6 +140,7 @@ struct app::arguments
         bool run = false;
     } traveler;
     numbering_def numbering;
+    layout_budget layout;
 
     
 public:
@@ -102,8 +161,142 @@ void app::run(
 {
     APP_DEBUG_FNAME;
     
+    if (args.size() > 1 && args[1] == ARGS_COMPILE_TEMPLATE)
+    {
+        compile_template(args);
+        return;
+    }
+    if (args.size() > 1 && args[1] == ARGS_SERVE)
+    {
+        serve(args);
+        return;
+    }
+    
+    // profiling starts before parsing, which prepares the template
+    if (find(args.begin(), args.end(), ARGS_PROFILE) != args.end())
+        profiler::enable();
+    // without perf events stages are only timed, report tells why
+    if (find(args.begin(), args.end(), ARGS_PROFILE_COUNTERS) != args.end())
+        profiler::enable_counters();
+    
     args.push_back("");
-    run(arguments::parse(args));
+    arguments parsed = arguments::parse(args);
+    string profile = parsed.profile;
+    
+    // report is written for failed runs too
+    auto save_profile = [&profile]()
+    {
+        if (profile.empty())
+            return;
+        try
+        {
+            profiler::save(profile);
+            INFO("Profile written to %s", profile);
+        }
+        catch (const my_exception& e)
+        {
+            ERR("%s", e);
+        }
+    };
+    
+    try
+    {
+        run(move(parsed));
+    }
+    catch (...)
+    {
+        save_profile();
+        throw;
+    }
+    save_profile();
+}
+
+void app::compile_template(
+                           const std::vector<std::string>& args)
+{
+    APP_DEBUG_FNAME;
+    
+    size_t i = 2;
+    string templatetype = "crw";
+    
+    if (i < args.size() && args[i] == ARGS_TEMPLATE_STRUCTURE_FILE_TYPE)
+    {
+        if (i + 1 == args.size())
+            throw aplication_error("File format is missing, try running %s --help for more arguments details", args[0]).with(ERROR_ARGUMENTS);
+        templatetype = args[i + 1];
+        i += 2;
+    }
+    if (args.size() != i + 3)
+        throw aplication_error("Template and bundle files are missing, try running %s --help for more arguments details", args[0]).with(ERROR_ARGUMENTS);
+    
+    rna_tree templated = create_templated(args[i], templatetype, args[i + 1]);
+    
+    try
+    {
+        traveler::save_template_bundle(templated, args[i + 2]);
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Compiling template failed: %s", e).with(ERROR_ARGUMENTS);
+    }
+    
+    INFO("Template %s compiled to %s", templated.name(), args[i + 2]);
+}
+
+void app::serve(
+                const std::vector<std::string>& args)
+{
+    APP_DEBUG_FNAME;
+    
+    server::options opts;
+    vector<string> verbose = ARGS_VERBOSE;
+    
+    try
+    {
+        for (size_t i = 2; i < args.size(); ++i)
+        {
+            const string& arg = args[i];
+            
+            if (arg == ARGS_SOCKET)
+                opts.socket = args.at(++i);
+            else if (arg == ARGS_SERVE_TEMPLATE)
+            {
+                string id = args.at(++i);
+                opts.templates[id] = args.at(++i);
+            }
+            else if (arg == ARGS_THREADS)
+                opts.threads = stoul(args.at(++i));
+            else if (arg == ARGS_TIMEOUT)
+                opts.timeout = stod(args.at(++i));
+            else if (arg == ARGS_LAYOUT_MAX_ITERATIONS)
+                opts.layout.max_iterations = stoul(args.at(++i));
+            else if (arg == ARGS_LAYOUT_TIME_BUDGET)
+                opts.layout.time = stod(args.at(++i));
+            else if (find(verbose.begin(), verbose.end(), arg) != verbose.end())
+                logger.set_priority(logger::INFO);
+            else
+                throw wrong_argument_exception("Unknown argument %s", arg);
+        }
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Error while parsing arguments: %s", e).with(ERROR_ARGUMENTS);
+    }
+    catch (const std::exception&)
+    {
+        throw aplication_error("Missing or wrong value of argument, try running %s --help for more arguments details", args[0]).with(ERROR_ARGUMENTS);
+    }
+    if (opts.socket.empty() || opts.templates.empty())
+        throw aplication_error("Socket and at least one template are required, try running %s --help for more arguments details", args[0]).with(ERROR_ARGUMENTS);
+    
+    try
+    {
+        server(opts).run();
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Serving failed: %s", e).with(ERROR_ARGUMENTS);
+    }
 }
 
 
@@ -116,58 +309,310 @@ void app::run(
     
     INFO("BEG: APP");
     
+    if (!args.batch.empty())
+    {
+        run_batch(args);
+        INFO("END: APP");
+        return;
+    }
+    
     print(args);
+    
+    // targets are read one by one, the next one is read ahead
+    // to find out whether there are more of them
+    fasta target, following;
+    bool has_target, has_following;
+    try
+    {
+        structure_reader reader(args.targets);
+        
+        has_target = reader.next(target);
+        has_following = has_target && reader.next(following);
+        if (!has_target)
+            throw wrong_argument_exception("File %s does not contain any structure", args.targets);
+        
+        bool multiple = has_following;
+        size_t failed = 0;
+        int status = ERROR_DEFAULT;
+        
+        for (size_t number = 1; has_target; ++number)
+        {
+            try
+            {
+                run_target(args, target, number, multiple);
+            }
+            catch (const aplication_error& e)
+            {
+                // one failed target does not stop the others
+                if (!multiple)
+                    throw;
+                ERR("Target %s (%s) failed: %s", number, target.id, e);
+                status = e.get_return_status();
+                ++failed;
+            }
+            
+            has_target = has_following;
+            swap(target, following);
+            if (has_target)
+                has_following = reader.next(following);
+        }
+        
+        if (failed != 0)
+            throw aplication_error("%s targets failed", failed).with(status);
+    }
+    catch (const aplication_error&)
+    {
+        throw;
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Reading target structures failed: %s", e).with(ERROR_ARGUMENTS);
+    }
+    
+    INFO("END: APP");
+}
+
+void app::run_batch(
+                    const arguments& args)
+{
+    APP_DEBUG_FNAME;
+    
+    typedef chrono::steady_clock clock;
+    
+    ifstream manifest(args.batch);
+    if (!manifest)
+        throw aplication_error("Batch manifest %s can not be opened", args.batch).with(ERROR_ARGUMENTS);
+    vector<batch_job> jobs = read_batch_manifest(manifest, args.batch);
+    
+    // jobs sharing template files share the template, keyed by its columns
+    vector<string> keys;
+    map<string, vector<string>> templates;
+    for (const batch_job& job : jobs)
+    {
+        string key;
+        for (const string& column : job.templated)
+            key += column + "\t";
+        keys.push_back(key);
+        templates[key] = job.templated;
+    }
+    
+    // templates are prepared once and shared by their jobs,
+    // a template which can not be prepared fails only its jobs
+    map<string, rna_tree> prepared;
+    map<string, string> unprepared;
+    for (const auto& t : templates)
+    {
+        try
+        {
+            if (t.second.size() == 1)
+                prepared[t.first] = traveler::load_template_bundle(t.second[0]);
+            else
+                prepared[t.first] = create_templated(t.second[1], t.second[0], t.second[2]);
+        }
+        catch (const my_exception& e)
+        {
+            unprepared[t.first] = e.what();
+        }
+    }
+    
+    size_t threads = args.threads != 0 ? args.threads : max(1u, thread::hardware_concurrency());
+    threads = min(threads, max<size_t>(jobs.size(), 1));
+    
+    INFO("Batch %s: %s jobs, %s templates, %s threads", args.batch, jobs.size(), templates.size(), threads);
+    
+    atomic<size_t> next(0), failed(0);
+    auto start = clock::now();
+    
+    auto worker =
+    [&]()
+    {
+        for (size_t i = next++; i < jobs.size(); i = next++)
+        {
+            const batch_job& job = jobs[i];
+            const string& key = keys[i];
+            const string& template_name = job.templated.size() == 1 ? job.templated[0] : job.templated[1];
+            try
+            {
+                if (unprepared.count(key) != 0)
+                    throw aplication_error("%s", unprepared.at(key)).with(ERROR_ARGUMENTS);
+                
+                // ids and log messages of the job do not depend on other jobs
+                job_context context("job " + to_string(job.line));
+                job_context::scope entered(context);
+                
+                arguments job_args = args;
+                job_args.batch.clear();
+                job_args.templated = prepared.at(key);
+                job_args.targets = job.targets;
+                job_args.all.run = true;
+                job_args.all.file = job.file;
+                
+                run(job_args);
+            }
+            catch (const exception& e)
+            {
+                // jobs are isolated, failure is reported and others go on
+                ERR("execution of %s <-> %s failed (manifest line %s): %s",
+                    template_name, job.targets, job.line, e.what());
+                ++failed;
+            }
+        }
+    };
+    
+    vector<thread> pool;
+    for (size_t i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool)
+        t.join();
+    
+    double seconds = chrono::duration<double>(clock::now() - start).count();
+    INFO("Batch %s: %s jobs done, %s failed in %s s", args.batch, jobs.size(), failed.load(), seconds);
+    
+    if (failed != 0)
+        throw aplication_error("%s of %s batch jobs failed", failed.load(), jobs.size()).with(ERROR_DEFAULT);
+}
+
+/* static */ vector<app::batch_job> app::read_batch_manifest(
+                                                            std::istream& in,
+                                                            const std::string& name)
+{
+    // manifest line: TEMPLATE_IMAGE TEMPLATE_DBN TARGET_DBN OUT_PREFIX [FILE_FORMAT]
+    //             or BUNDLE_FILE TARGET_DBN OUT_PREFIX, columns separated by tabs
+    vector<batch_job> jobs;
+    
+    string line;
+    for (size_t number = 1; getline(in, line); ++number)
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+        
+        vector<string> columns;
+        size_t begin = 0, end;
+        do
+        {
+            end = line.find('\t', begin);
+            columns.push_back(line.substr(begin, end - begin));
+            begin = end + 1;
+        } while (end != string::npos);
+        
+        batch_job job;
+        if (columns.size() == 3)
+            job.templated = {columns[0]};
+        else if (columns.size() == 4 || columns.size() == 5)
+            job.templated = {columns.size() == 5 ? columns[4] : "crw", columns[0], columns[1]};
+        else
+            throw aplication_error("Batch manifest %s: line %s has %s columns, 3, 4 or 5 are expected",
+                                   name, number, columns.size()).with(ERROR_ARGUMENTS);
+        
+        job.line = number;
+        job.targets = columns[columns.size() == 3 ? 1 : 2];
+        job.file = columns[columns.size() == 3 ? 2 : 3];
+        jobs.push_back(job);
+    }
+    
+    return jobs;
+}
+
+void app::run_target(
+                     const arguments& args,
+                     const fasta& target,
+                     size_t number,
+                     bool multiple)
+{
+    APP_DEBUG_FNAME;
+    
+    auto output_name = [&](const string& pattern)
+    {
+        return get_output_name(pattern, target.id, number, multiple);
+    };
+    
     bool rted = args.all.run || args.ted.run || args.traveler.run;
     bool draw = args.all.run || args.draw.run;
     bool overlaps = args.all.overlap_checks || args.draw.overlap_checks;
     mapping map;
-    string img_out = args.all.file;
+    string img_out = output_name(args.all.file);
     
-    map = run_ted(args.templated, args.matched, rted, args.ted.mapping);
+    // template is laid out again for every target
+    rna_tree templated = args.templated;
+    rna_tree matched = create_matched(target);
     
-    if (args.draw.run)
+    // mapping computed in this run is drawn directly, mapping file
+    // of --draw is read only when tree-edit-distance does not run
+    if (rted)
+    {
+        map = run_ted(templated, matched, output_name(args.ted.mapping));
+        if (args.draw.run && args.draw.mapping != args.ted.mapping)
+            INFO("Computed mapping is drawn instead of mapping in %s", output_name(args.draw.mapping));
+    }
+    else if (args.draw.run)
     {
         assert(!args.draw.mapping.empty());
-        map = load_mapping_table(args.draw.mapping);
-        img_out = args.draw.file;
+        try
+        {
+            map = load_mapping_table(output_name(args.draw.mapping));
+        }
+        catch (const my_exception& e)
+        {
+            throw aplication_error("Loading mapping failed: %s", e).with(ERROR_ARGUMENTS);
+        }
     }
+    
+    if (args.draw.run)
+        img_out = output_name(args.draw.file);
 
-    run_drawing(args.templated, args.matched, map, draw, overlaps, args.rotate_branches, img_out, args.numbering);
+    run_drawing(templated, matched, map, draw, overlaps, args.rotate_branches, args.layout, img_out, args.numbering, args.compress, args.binary_layout);
+}
+
+/* static */ std::string app::get_output_name(
+                                              const std::string& pattern,
+                                              const std::string& id,
+                                              size_t number,
+                                              bool multiple)
+{
+    if (pattern.empty())
+        return pattern;
     
-    INFO("END: APP");
+    // id is a part of file name, it can not contain directories
+    string safe_id = id;
+    for (char& ch : safe_id)
+        if (!isalnum(static_cast<unsigned char>(ch)) && ch != '.' && ch != '-' && ch != '_')
+            ch = '_';
+    
+    string name = pattern;
+    bool replaced = false;
+    for (const auto& placeholder : {make_pair(string("{id}"), safe_id),
+                                    make_pair(string("{n}"), to_string(number))})
+    {
+        size_t pos;
+        while ((pos = name.find(placeholder.first)) != string::npos)
+        {
+            name.replace(pos, placeholder.first.size(), placeholder.second);
+            replaced = true;
+        }
+    }
+    
+    if (multiple && !replaced)
+        name += "." + to_string(number);
+    
+    return name;
 }
 
 mapping app::run_ted(
                      rna_tree& templated,
                      rna_tree& matched,
-                     bool run,
                      const std::string& mapping_file)
 {
     APP_DEBUG_FNAME;
     
     try
     {
-        mapping mapping;
+        mapping mapping = traveler::compute_mapping(templated, matched);
         
-        if (run)
-        {
-            
-           
-            rted r(templated, matched); //Gets a strategy for decomposing a tree
-            r.run();
-            
-            gted g(templated, matched); //Computes mapping and ditstanve based on RTED's strategy (faster than using GTED itself)
-            g.run(r.get_strategies());
-    
-            mapping = g.get_mapping();
-            
-            if (!mapping_file.empty())
-                save_tree_mapping_table(mapping_file, mapping);
-        }
-        else
-        {
-            INFO("skipping rted run, returning default mapping");
-        }
+        if (!mapping_file.empty())
+            save_tree_mapping_table(mapping_file, mapping);
         
         return mapping;
     }
@@ -186,8 +631,11 @@ void app::run_drawing(
                       bool run,
                       bool run_overlaps,
                       bool rotate_branches,
+                      const layout_budget& layout,
                       const std::string& file,
-                      const numbering_def& numbering)
+                      const numbering_def& numbering,
+                      bool compress,
+                      bool binary_layout)
 {
     APP_DEBUG_FNAME;
 
@@ -200,13 +648,21 @@ void app::run_drawing(
             return;
         }
         
-        //Based on a mapping, matcher returns structure with deleted and inserted nodes
-        // which correspond to the target structure
-        templated = matcher(templated, matched).run(mapping);
-        //Compact goes through the structure and computes new coordinates where necessary
-            compact(templated).run(rotate_branches);
+        traveler::layout_options options;
+        options.rotate_branches = rotate_branches;
+        options.budget = layout;
+        traveler::layout_stats stats = traveler::layout(templated, matched, mapping, options);
+        if (!stats.iterations.empty())
+        {
+            const compact::iteration_stats& last = stats.iterations.back();
+            size_t moved = 0;
+            for (const auto& i : stats.iterations)
+                moved += i.moved_branches;
+            INFO("Layout beautified in %s rounds, moved branches %s, last round overlaps %s%s",
+                 stats.iterations.size(), moved, last.overlaps, last.reverted ? ", reverted" : "");
+        }
 
-        save(file, templated, run_overlaps, numbering);
+        save(file, templated, run_overlaps, numbering, compress, binary_layout);
     }
     catch (const my_exception& e)
     {
@@ -218,51 +674,78 @@ void app::save(
                const std::string& filename,
                rna_tree& rna,
                bool overlap,
-               const numbering_def& numbering)
+               const numbering_def& numbering,
+               bool compress,
+               bool binary_layout)
 {
     APP_DEBUG_FNAME;
     
-    overlap_checks::overlaps overlaps;
-//    if (overlap)
-        overlaps = overlap_checks().run(rna);
+    lazy_overlaps overlaps(rna);
+    // everything drawn is collected once and shared by all writers
+    render_model model = overlap ?
+        traveler::get_render_model(rna, numbering, overlaps.get()) :
+        traveler::get_render_model(rna, numbering);
     
+    image_writers writers;
     for (bool colored : {true, false})
     {
-        for (auto& writer : document_writer::get_writers(colored))
+        for (auto& writer : document_writer::get_writers(colored, compress, binary_layout))
         {
             writer->set_scaling_ratio(rna);
             string file = colored ? filename + COLORED_FILENAME_EXTENSION : filename;
             writer->init(file, rna);
-            writer->print(writer->get_rna_formatted(rna, numbering));
-
-            if (overlap)
-                for (const auto& p : overlaps)
-                    writer->print(writer->get_circle_formatted(p.centre, p.radius));
+            writers.push_back(move(writer));
         }
     }
+    
+    // documents are independent and model is only read, so they are
+    // formatted and written in parallel; get() rethrows writing errors
+    vector<future<void>> written;
+    for (auto& writer : writers)
+    {
+        document_writer* w = writer.get();
+        // stage is named by suffix of document, eg. "write colored.svg"
+        string stage = "write " + w->get_write_stats().file.substr(filename.size() + 1);
+        written.push_back(async(launch::async,
+                                [w, &model, stage]()
+                                {
+                                    PROFILE_STAGE(stage.c_str());
+                                    w->print(model);
+                                    w->close();
+                                }));
+    }
+    for (auto& f : written)
+        f.get();
+    
+    for (const auto& writer : writers)
+    {
+        const document_writer::write_stats& stats = writer->get_write_stats();
+        INFO("Written %s: %s B, stored %s B (ratio %s) in %s s (%s MB/s)",
+             stats.file, stats.bytes, stats.stored, stats.get_ratio(),
+             stats.seconds, stats.get_throughput());
+    }
 
-//    if (overlap)
-//    {
-        INFO("Overlaps count: %s", overlaps.size());
-//    }
-//    else
-//    {
-//        INFO("Overlaps computation was skipped for %s", rna.name());
-//    }
+    if (overlaps.is_computed())
+    {
+        INFO("Overlaps count: %s", overlaps.get().size());
+    }
+    else
+    {
+        INFO("Overlaps computation was skipped for %s", rna.name());
+    }
 }
 
 
 
 
 rna_tree app::create_matched(
-                             const std::string& fastafile)
+                             const fasta& target)
 {
     APP_DEBUG_FNAME;
     
     try
     {
-        fasta f = read_fasta_file(fastafile);
-        return rna_tree(f.brackets, f.labels, f.id);
+        return traveler::build_target(target);
     }
     catch (const my_exception& e)
     {
@@ -279,11 +762,7 @@ rna_tree app::create_templated(
     
     try
     {
-        extractor_ptr doc = extractor::get_extractor(templatefile, templatetype);
-        fasta f = read_fasta_file(fastafile);
-        doc->adjust_residues_lists(f.brackets.size());
-
-        return rna_tree(f.brackets, doc->labels, doc->points, f.id);
+        return traveler::load_template(templatefile, templatetype, fastafile);
     }
     catch (const my_exception& e)
     {
@@ -328,6 +807,32 @@ void app::usage(
     << " [" << ARGS_TEMPLATE_STRUCTURE_FILE_TYPE << " FILE_FORMAT]"
     << " IMAGE_FILE DBN_FILE"
     << endl
+    << appname
+    << " [OPTIONS]"
+    << " <" << get_args(ARGS_TARGET_STRUCTURE) << ">"
+    << " DBN_FILE"
+    << " <" << get_args(ARGS_TEMPLATE_BUNDLE) << ">"
+    << " BUNDLE_FILE"
+    << endl
+    << appname
+    << " " << ARGS_COMPILE_TEMPLATE
+    << " [" << ARGS_TEMPLATE_STRUCTURE_FILE_TYPE << " FILE_FORMAT]"
+    << " IMAGE_FILE DBN_FILE BUNDLE_FILE"
+    << endl
+    << appname
+    << " " << ARGS_SERVE
+    << " " << ARGS_SOCKET << " SOCKET_FILE"
+    << " " << ARGS_SERVE_TEMPLATE << " ID BUNDLE_FILE..."
+    << " [" << ARGS_THREADS << " THREADS]"
+    << " [" << ARGS_TIMEOUT << " SECONDS]"
+    << endl
+    << appname
+    << " [OPTIONS]"
+    << " <" << get_args(ARGS_BATCH) << ">"
+    << " MANIFEST_FILE"
+    << " [" << ARGS_THREADS << " THREADS]"
+    << " [" << ARGS_ALL_OVERLAPS << "]"
+    << endl
     << endl
     << "OPTIONS:" << endl
     << "\t[" << get_args(ARGS_ALL)
@@ -341,6 +846,12 @@ void app::usage(
     << "\t[" << get_args(ARGS_VERBOSE) << "]"
     << endl
     << "\t[" << get_args(ARGS_ROTATE_BRANCHES) << "]"
+    << " [" << ARGS_LAYOUT_MAX_ITERATIONS << " ITERATIONS]"
+    << " [" << ARGS_LAYOUT_TIME_BUDGET << " SECONDS]"
+    << endl
+    << "\t[" << ARGS_COMPRESS << "]"
+    << " [" << ARGS_BINARY_LAYOUT << "]"
+    << " [" << ARGS_PROFILE << " FILE_OUT [" << ARGS_PROFILE_COUNTERS << "]]"
     << endl;
 }
 
@@ -351,7 +862,7 @@ void app::print(
     
     INFO("ARGUMENTS:\n"
          "templated: %s: %s\n"
-         "matched: %s: %s\n"
+         "targets: %s\n"
          "all:\n"
          "\trun=%s\n"
          "\timage-file=%s\n"
@@ -364,13 +875,20 @@ void app::print(
          "\toverlaps=%s\n"
          "\tmapping-file=%s\n"
          "\timage-file=%s"
-         "\rotate=%s\n",
+         "\rotate=%s\n"
+         "layout:\n"
+         "\tmax-iterations=%s\n"
+         "\ttime-budget=%s\n"
+         "compress=%s\n"
+         "binary-layout=%s\n",
          args.templated.name(), args.templated.print_tree(false),
-         args.matched.name(), args.matched.print_tree(false),
+         args.targets,
          args.all.run, args.all.file, args.all.overlap_checks,
          args.ted.run, args.ted.mapping,
          args.draw.run, args.draw.overlap_checks, args.draw.mapping, args.draw.file,
-         args.rotate_branches);
+         args.rotate_branches,
+         args.layout.max_iterations, args.layout.time,
+         args.compress, args.binary_layout);
     
     
 }
@@ -430,8 +948,9 @@ void app::print(
             else if (is_argument(ARGS_TARGET_STRUCTURE))
             {
                 DEBUG("arg match-tree");
-                string fastafile = args.at(i + 1);
-                a.matched = app::create_matched(fastafile);
+                a.targets = args.at(i + 1);
+                if (!exist_file(a.targets))
+                    throw io_exception("Target structure file %s does not exist", a.targets);
                 ++i;
                 continue;
             }
@@ -450,6 +969,33 @@ void app::print(
                 a.templated = app::create_templated(templatefile, templatetype, fastafile);
                 i += 2;
             }
+            else if (arg == ARGS_ALL_OVERLAPS)
+            {
+                // overlaps of batch jobs, which have no --all
+                a.all.overlap_checks = true;
+            }
+            else if (is_argument(ARGS_BATCH))
+            {
+                DEBUG("arg batch");
+                a.batch = args.at(i + 1);
+                if (!exist_file(a.batch))
+                    throw io_exception("Batch manifest %s does not exist", a.batch);
+                ++i;
+            }
+            else if (arg == ARGS_THREADS)
+            {
+                try {
+                    a.threads = stoul(args.at(++i));
+                } catch (...) {
+                    throw wrong_argument_exception("Unsupported threads count");
+                };
+            }
+            else if (is_argument(ARGS_TEMPLATE_BUNDLE))
+            {
+                DEBUG("arg template-bundle");
+                a.templated = traveler::load_template_bundle(args.at(i + 1));
+                ++i;
+            }
             else if (is_argument(ARGS_ALL))
             {
                 DEBUG("arg all");
@@ -497,6 +1043,38 @@ void app::print(
                 a.rotate_branches = true;
 
             }
+            else if (arg == ARGS_COMPRESS)
+            {
+                a.compress = true;
+            }
+            else if (arg == ARGS_BINARY_LAYOUT)
+            {
+                a.binary_layout = true;
+            }
+            else if (arg == ARGS_PROFILE)
+            {
+                a.profile = args.at(++i);
+            }
+            else if (arg == ARGS_PROFILE_COUNTERS)
+            {
+                a.profile_counters = true;
+            }
+            else if (arg == ARGS_LAYOUT_MAX_ITERATIONS)
+            {
+                try {
+                    a.layout.max_iterations = stoul(args.at(++i));
+                } catch (...) {
+                    throw wrong_argument_exception("Unsupported layout iterations count");
+                };
+            }
+            else if (arg == ARGS_LAYOUT_TIME_BUDGET)
+            {
+                try {
+                    a.layout.time = stod(args.at(++i));
+                } catch (...) {
+                    throw wrong_argument_exception("Unsupported layout time budget");
+                };
+            }
             else if (is_argument(ARGS_VERBOSE))
             {
                 logger.set_priority(logger::INFO);
@@ -533,9 +1111,18 @@ void app::print(
             }
         }
         
-        if (a.templated == rna_tree() || a.matched == rna_tree())
+        if (!a.batch.empty())
+        {
+            // every job has its own structures and writes all outputs
+            if (!(a.templated == rna_tree()) || !a.targets.empty() || a.all.run || a.ted.run || a.draw.run)
+                throw wrong_argument_exception("Structures and outputs are given by batch manifest, try running %s --help for more arguments details", args[0]);
+        }
+        else if (a.templated == rna_tree() || a.targets.empty())
             throw wrong_argument_exception("RNA structures are missing, try running %s --help for more arguments details", args[0]);
 
+        if (a.profile_counters && a.profile.empty())
+            throw wrong_argument_exception("%s needs %s FILE_OUT", ARGS_PROFILE_COUNTERS, ARGS_PROFILE);
+
         a.fill_default();
 
         return a;
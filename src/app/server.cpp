@@ -0,0 +1,372 @@
+/*
+ * File: server.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.hpp"
+#include "traveler.hpp"
+#include "structure_reader.hpp"
+#include "job_context.hpp"
+
+// pending connections queued by kernel
+#define SERVER_BACKLOG              128
+// seconds client has to send whole request
+#define SERVER_READ_TIMEOUT         30
+#define SERVER_MAX_REQUEST_SIZE     (256 << 20)
+#define SERVER_READ_SIZE            (64 << 10)
+
+using namespace std;
+
+namespace
+{
+    double seconds_since(
+                         chrono::steady_clock::time_point& since)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        double seconds = chrono::duration<double>(now - since).count();
+        since = now;
+        return seconds;
+    }
+
+    bool parse_flag(
+                    const string& key,
+                    const string& value)
+    {
+        if (value == "1")
+            return true;
+        if (value == "0")
+            return false;
+        throw wrong_argument_exception("Request value of %s has to be 0 or 1", key);
+    }
+
+    /**
+     * writes whole `text` to `connection`, client may be gone already
+     */
+    bool send_all(
+                  int connection,
+                  const string& text)
+    {
+        size_t sent = 0;
+        while (sent != text.size())
+        {
+            ssize_t written = send(connection, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            sent += written;
+        }
+        return true;
+    }
+}
+
+
+std::string server::request_stats::to_json() const
+{
+    string json = msprintf("{\"residues\": %s, \"bytes\": %s, \"parse\": %s, \"ted\": %s, "
+                           "\"layout\": %s, \"render\": %s, \"total\": %s, \"rounds\": [",
+                           residues, bytes, parse, ted, layout, render, total);
+    for (size_t i = 0; i < rounds.size(); ++i)
+        json += msprintf("%s{\"overlaps\": %s, \"moved_branches\": %s, \"time\": %s, \"reverted\": %s}",
+                         i == 0 ? "" : ", ", rounds[i].overlaps, rounds[i].moved_branches,
+                         rounds[i].time, rounds[i].reverted ? "true" : "false");
+    return json + msprintf("], \"processed\": %s, \"reused\": %s}", reuse.processed, reuse.reused);
+}
+
+
+server::server(
+               const options& _opts)
+    : opts(_opts)
+{
+    APP_DEBUG_FNAME;
+
+    for (const auto& t : opts.templates)
+    {
+        INFO("Loading template %s from %s", t.first, t.second);
+        templates.emplace(t.first, traveler::load_template_bundle(t.second));
+    }
+    if (opts.threads == 0)
+        opts.threads = max(1u, thread::hardware_concurrency());
+}
+
+void server::run()
+{
+    APP_DEBUG_FNAME;
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (opts.socket.empty() || opts.socket.size() >= sizeof(address.sun_path))
+        throw wrong_argument_exception("Socket path '%s' is empty or too long", opts.socket);
+    strcpy(address.sun_path, opts.socket.c_str());
+
+    // socket left by previous server is replaced, other files are not
+    struct stat status;
+    if (lstat(opts.socket.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(opts.socket.c_str());
+
+    int listening = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listening < 0)
+        throw io_exception("Creating socket failed: %s", strerror(errno));
+    if (bind(listening, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listening, SERVER_BACKLOG) != 0)
+    {
+        int error = errno;
+        ::close(listening);
+        throw io_exception("Listening on %s failed: %s", opts.socket, strerror(error));
+    }
+
+    INFO("Serving %s templates on %s by %s threads", templates.size(), opts.socket, opts.threads);
+
+    // templates are only read from now on, so workers share them
+    vector<thread> workers;
+    for (size_t i = 0; i < opts.threads; ++i)
+        workers.emplace_back(&server::serve, this, listening);
+    for (thread& t : workers)
+        t.join();
+
+    ::close(listening);
+}
+
+void server::serve(
+                   int listening)
+{
+    while (true)
+    {
+        int connection = accept(listening, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE)
+                continue;
+            ERR("Accepting connection failed: %s", strerror(errno));
+            return;
+        }
+
+        handle(connection);
+        ::close(connection);
+    }
+}
+
+void server::handle(
+                    int connection)
+{
+    timeval read_timeout = {SERVER_READ_TIMEOUT, 0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &read_timeout, sizeof(read_timeout));
+
+    string response;
+    try
+    {
+        // request ends when client shuts down its side of connection
+        string text;
+        while (true)
+        {
+            size_t size = text.size();
+            text.resize(size + SERVER_READ_SIZE);
+            ssize_t received = recv(connection, &text[size], SERVER_READ_SIZE, 0);
+            if (received < 0)
+            {
+                text.resize(size);
+                if (errno == EINTR)
+                    continue;
+                throw io_exception("Reading request failed: %s", strerror(errno));
+            }
+            text.resize(size + received);
+            if (received == 0)
+                break;
+            if (text.size() > SERVER_MAX_REQUEST_SIZE)
+                throw wrong_argument_exception("Request is larger than %s B", SERVER_MAX_REQUEST_SIZE);
+        }
+
+        request r = parse_request(text);
+        double timeout = opts.timeout;
+        if (r.timeout > 0 && (timeout == 0 || r.timeout < timeout))
+            timeout = r.timeout;
+
+        string document;
+        shared_ptr<request_stats> stats = make_shared<request_stats>();
+        if (timeout == 0)
+            document = process(r, *stats);
+        else
+        {
+            // layout can not be interrupted, when it runs out of time
+            // client gets an error and layout finishes in background;
+            // their number is bounded, so that `threads` still bounds load
+            if (abandoned >= opts.threads)
+                throw illegal_state_exception("Server is busy, %s timed out layouts are still running",
+                                              size_t(abandoned));
+
+            enum { running, finished, timed_out };
+            auto state = make_shared<atomic<int>>(running);
+            auto task = make_shared<packaged_task<string()>>(
+                                                             [this, r, stats]()
+                                                             {
+                                                                 return process(r, *stats);
+                                                             });
+            future<string> result = task->get_future();
+            thread([this, task, state]()
+                   {
+                       (*task)();
+                       if (state->exchange(finished) == timed_out)
+                           --abandoned;
+                   }).detach();
+
+            if (result.wait_for(chrono::duration<double>(timeout)) == future_status::timeout)
+            {
+                // counted before it is marked, so that finishing layout
+                // never decrements first
+                ++abandoned;
+                int expected = running;
+                if (state->compare_exchange_strong(expected, timed_out))
+                    throw illegal_state_exception("Request timed out after %s s", timeout);
+                --abandoned;
+            }
+            document = result.get();
+        }
+
+        INFO("Request %s: %s", r.templated, stats->to_json());
+        response = msprintf("OK %s\n", document.size()) + document +
+            "STATS " + stats->to_json() + "\n";
+    }
+    catch (const my_exception& e)
+    {
+        string message = e.what();
+        replace(message.begin(), message.end(), '\n', ' ');
+        WARN("Request failed: %s", message);
+        response = "ERROR " + message + "\n";
+    }
+    catch (const std::exception& e)
+    {
+        ERR("Request failed: %s", e.what());
+        response = string("ERROR ") + e.what() + "\n";
+    }
+
+    if (!send_all(connection, response))
+        WARN("Sending response failed: %s", strerror(errno));
+}
+
+/* static */ server::request server::parse_request(
+                                                   const std::string& text)
+{
+    request r;
+    size_t position = 0;
+
+    while (true)
+    {
+        size_t end = text.find('\n', position);
+        if (end == string::npos)
+            throw wrong_argument_exception("Request has no empty line after header");
+
+        string line = text.substr(position, end - position);
+        position = end + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            break;
+
+        size_t space = line.find(' ');
+        string key = line.substr(0, space);
+        string value = space == string::npos ? "" : line.substr(space + 1);
+
+        if (key == "template")
+            r.templated = value;
+        else if (key == "format")
+            r.format = value;
+        else if (key == "colored")
+            r.colored = parse_flag(key, value);
+        else if (key == "overlaps")
+            r.overlaps = parse_flag(key, value);
+        else if (key == "rotate")
+            r.rotate = parse_flag(key, value);
+        else if (key == "timeout")
+        {
+            char* number_end;
+            r.timeout = strtod(value.c_str(), &number_end);
+            if (value.empty() || *number_end != '\0' || !(r.timeout > 0))
+                throw wrong_argument_exception("Unsupported request timeout %s", value);
+        }
+        else
+            throw wrong_argument_exception("Unknown request header %s", key);
+    }
+
+    if (r.templated.empty())
+        throw wrong_argument_exception("Request has no template");
+    // unknown format is reported before anything is computed
+    traveler::get_format(r.format);
+
+    r.target = text.substr(position);
+    return r;
+}
+
+std::string server::process(
+                            const request& r,
+                            request_stats& stats) const
+{
+    // requests are laid out concurrently, each has its own ids
+    job_context context("request " + r.templated);
+    job_context::scope entered(context);
+    APP_DEBUG_FNAME;
+
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    chrono::steady_clock::time_point stage = begin;
+
+    auto it = templates.find(r.templated);
+    if (it == templates.end())
+        throw wrong_argument_exception("Unknown template %s", r.templated);
+
+    rna_tree templated = it->second;
+    fasta structure = structure_reader::read_text(r.target, "target");
+    rna_tree target = traveler::build_target(structure);
+    stats.residues = structure.labels.size();
+    stats.parse = seconds_since(stage);
+
+    mapping m = traveler::compute_mapping(templated, target);
+    stats.ted = seconds_since(stage);
+
+    traveler::layout_options options;
+    options.rotate_branches = r.rotate;
+    options.budget = opts.layout;
+    traveler::layout_stats layout = traveler::layout(templated, target, m, options);
+    stats.rounds = layout.iterations;
+    stats.reuse = layout.reuse;
+    stats.layout = seconds_since(stage);
+
+    render_model model = r.overlaps ?
+        traveler::get_render_model(templated, opts.numbering, traveler::find_overlaps(templated)) :
+        traveler::get_render_model(templated, opts.numbering);
+    string document = traveler::render(templated, model, traveler::get_format(r.format), r.colored);
+    stats.bytes = document.size();
+    stats.render = seconds_since(stage);
+    stats.total = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    return document;
+}
@@ -0,0 +1,208 @@
+/*
+ * File: traveler.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "traveler.hpp"
+#include "utils.hpp"
+#include "profiler.hpp"
+#include "structure_reader.hpp"
+#include "template_bundle.hpp"
+#include "extractor.hpp"
+#include "tree_matcher.hpp"
+#include "compact.hpp"
+#include "rted.hpp"
+#include "gted.hpp"
+#include "svg_writer.hpp"
+#include "ps_writer.hpp"
+#include "traveler_writer.hpp"
+#include "layout_writer.hpp"
+
+using namespace std;
+
+/* static */ rna_tree traveler::load_template(
+                                              const std::string& image_file,
+                                              const std::string& image_format,
+                                              const std::string& structure_file)
+{
+    APP_DEBUG_FNAME;
+    
+    extractor_ptr doc;
+    fasta f;
+    {
+        PROFILE_STAGE("extraction");
+        doc = extractor::get_extractor(image_file, image_format);
+        f = read_structure_file(structure_file);
+        doc->adjust_residues_lists(f.brackets.size());
+    }
+    
+    PROFILE_STAGE("template tree");
+    return rna_tree(f.brackets, doc->labels, doc->points, f.id);
+}
+
+/* static */ rna_tree traveler::load_template_bundle(
+                                                     const std::string& bundle_file)
+{
+    PROFILE_STAGE("template bundle");
+    return template_bundle::load(bundle_file);
+}
+
+/* static */ void traveler::save_template_bundle(
+                                                 rna_tree& templated,
+                                                 const std::string& bundle_file)
+{
+    template_bundle::save(templated, bundle_file);
+}
+
+/* static */ rna_tree traveler::build_target(
+                                             const fasta& structure)
+{
+    PROFILE_STAGE("target tree");
+    return rna_tree(structure.brackets, structure.labels, structure.id);
+}
+
+/* static */ rna_tree traveler::build_target(
+                                             const std::string& text)
+{
+    return build_target(structure_reader::read_text(text, "target"));
+}
+
+/* static */ mapping traveler::compute_mapping(
+                                               rna_tree& templated,
+                                               rna_tree& target)
+{
+    APP_DEBUG_FNAME;
+    
+    rted r(templated, target); //Gets a strategy for decomposing a tree
+    r.run();
+    
+    gted g(templated, target); //Computes mapping and ditstanve based on RTED's strategy (faster than using GTED itself)
+    g.run(r.get_strategies());
+    
+    return g.get_mapping();
+}
+
+/* static */ traveler::layout_stats traveler::layout(
+                                                    rna_tree& templated,
+                                                    rna_tree& target,
+                                                    const mapping& m,
+                                                    const layout_options& options)
+{
+    APP_DEBUG_FNAME;
+    
+    //Based on a mapping, matcher returns structure with deleted and inserted nodes
+    // which correspond to the target structure
+    templated = matcher(templated, target).run(m);
+    //Compact goes through the structure and computes new coordinates where necessary
+    compact c(templated, options.budget);
+    c.run(options.rotate_branches);
+    
+    layout_stats stats;
+    stats.iterations = c.get_stats();
+    stats.reuse = c.get_reuse_stats();
+    return stats;
+}
+
+/* static */ overlap_checks::overlaps traveler::find_overlaps(
+                                                             rna_tree& rna)
+{
+    return overlap_checks().run(rna);
+}
+
+/* static */ render_model traveler::get_render_model(
+                                                     rna_tree& rna,
+                                                     const numbering_def& numbering,
+                                                     const overlap_checks::overlaps& overlaps)
+{
+    APP_DEBUG_FNAME;
+    PROFILE_STAGE("render model");
+    
+    numbering_def used = numbering;
+    if (used.positions.empty())
+    {
+        used.positions = {10, 20, 30};
+        used.interval = 50;
+    }
+    
+    render_model model = document_writer::get_render_model(
+                                                           rna, document_writer::get_numbering_labels(rna, used));
+    for (const auto& p : overlaps)
+        model.add_circle(p.centre, p.radius);
+    
+    return model;
+}
+
+/* static */ std::string traveler::render(
+                                          rna_tree& rna,
+                                          const render_model& model,
+                                          format_type format,
+                                          bool colored)
+{
+    APP_DEBUG_FNAME;
+    static const char* stages[] = {"write svg", "write ps", "write xml", "write json", "write binary"};
+    PROFILE_STAGE(stages[format]);
+    
+    string document;
+    unique_ptr<document_writer> writer = get_writer(format);
+    writer->use_colors(colored);
+    writer->use_memory(&document);
+    writer->set_scaling_ratio(rna);
+    // name only labels document in memory
+    writer->init(rna.name().empty() ? "rna" : rna.name(), rna);
+    writer->print(model);
+    writer->close();
+    
+    return document;
+}
+
+/* static */ std::unique_ptr<document_writer> traveler::get_writer(
+                                                                   format_type format)
+{
+    switch (format)
+    {
+        case svg:
+            return unique_ptr<document_writer>(new svg_writer());
+        case ps:
+            return unique_ptr<document_writer>(new ps_writer());
+        case xml:
+            return unique_ptr<document_writer>(new traveler_writer());
+        case json:
+            return unique_ptr<document_writer>(new layout_writer(layout_writer::json));
+        case binary:
+            return unique_ptr<document_writer>(new layout_writer(layout_writer::binary));
+    }
+    throw wrong_argument_exception("Unsupported document format %s", int(format));
+}
+
+/* static */ traveler::format_type traveler::get_format(
+                                                        const std::string& name)
+{
+    if (name == "svg")
+        return svg;
+    if (name == "ps")
+        return ps;
+    if (name == "xml")
+        return xml;
+    if (name == "json")
+        return json;
+    if (name == "binary")
+        return binary;
+    throw wrong_argument_exception("Unsupported document format %s", name);
+}
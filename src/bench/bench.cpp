@@ -0,0 +1,262 @@
+/*
+ * File: bench.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "bench.hpp"
+#include "profiler.hpp"
+#include "types.hpp"
+
+// samples taken of benchmarks without --repeat
+#define MICRO_SAMPLES           5
+#define MACRO_SAMPLES           1
+// bound of runs of body in one microbenchmark sample
+#define MAX_ITERATIONS          100000
+
+using namespace std;
+
+bench::bench(
+             const std::string& _root)
+    : root(_root)
+{
+    add_micro();
+    add_macro();
+}
+
+void bench::add(
+                const std::string& name,
+                bool macro,
+                setup prepare)
+{
+    benchmarks.push_back({(macro ? "macro/" : "micro/") + name, macro, prepare});
+}
+
+std::vector<std::string> bench::get_names() const
+{
+    vector<string> names;
+    for (const benchmark& b : benchmarks)
+        names.push_back(b.name);
+    return names;
+}
+
+bench::results bench::run(
+                          const options& opts) const
+{
+    results res;
+
+    // stages entered by bodies are reported with benchmarks
+    profiler::enable();
+    for (const benchmark& b : benchmarks)
+    {
+        if ((b.macro ? !opts.macro : !opts.micro) ||
+            b.name.find(opts.filter) == string::npos)
+            continue;
+
+        fprintf(stderr, "%-48s", b.name.c_str());
+        fflush(stderr);
+        try
+        {
+            res.push_back(measure(b, opts));
+            fprintf(stderr, " %12.6f s (%zu x %zu)\n",
+                    res.back().median, res.back().samples, res.back().iterations);
+        }
+        catch (const exception& e)
+        {
+            // failed benchmark does not stop others
+            result r;
+            r.name = b.name;
+            r.error = e.what();
+            res.push_back(r);
+            fprintf(stderr, " FAILED: %s\n", e.what());
+        }
+    }
+    profiler::disable();
+
+    return res;
+}
+
+bench::result bench::measure(
+                             const benchmark& b,
+                             const options& opts) const
+{
+    typedef chrono::steady_clock clock;
+
+    vector<string> stage_names;
+    map<string, double> stage_sums;
+
+    // one run of freshly prepared body, seconds
+    auto run_once =
+    [&](bool record)
+    {
+        body f = b.prepare();
+        profiler::clear();
+
+        clock::time_point begin = clock::now();
+        f();
+        double seconds = chrono::duration<double>(clock::now() - begin).count();
+
+        if (record)
+        {
+            for (const profiler::stage& s : profiler::get_stages())
+            {
+                if (stage_sums.count(s.name) == 0)
+                    stage_names.push_back(s.name);
+                stage_sums[s.name] += s.wall;
+            }
+        }
+        return seconds;
+    };
+
+    result r;
+    r.name = b.name;
+    r.samples = opts.repeat != 0 ? opts.repeat : b.macro ? MACRO_SAMPLES : MICRO_SAMPLES;
+    r.iterations = 1;
+
+    if (!b.macro)
+    {
+        // first run warms caches and allocator up and tells how many runs
+        // are needed for sample to be long enough to be measured reliably
+        double once = run_once(false);
+        if (once < opts.min_sample)
+            r.iterations = min<size_t>(MAX_ITERATIONS, size_t(ceil(opts.min_sample / max(once, 1e-9))));
+    }
+
+    vector<double> times;
+    for (size_t s = 0; s < r.samples; ++s)
+    {
+        double sample = 0;
+        for (size_t i = 0; i < r.iterations; ++i)
+            sample += run_once(true);
+        times.push_back(sample / r.iterations);
+    }
+
+    sort(times.begin(), times.end());
+    r.min = times.front();
+    r.max = times.back();
+    r.median = times.size() % 2 == 1 ? times[times.size() / 2] :
+        (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+    for (double t : times)
+        r.mean += t;
+    r.mean /= times.size();
+
+    for (const string& name : stage_names)
+        r.stages.emplace_back(name, stage_sums[name] / (r.samples * r.iterations));
+
+    return r;
+}
+
+/* static */ std::string bench::to_json(
+                                        const results& res)
+{
+    string json = "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < res.size(); ++i)
+    {
+        const result& r = res[i];
+        json += msprintf("%s\n    {\"name\": \"%s\", ", i == 0 ? "" : ",", r.name);
+        if (!r.error.empty())
+        {
+            string error = r.error;
+            replace(error.begin(), error.end(), '"', '\'');
+            replace(error.begin(), error.end(), '\n', ' ');
+            json += msprintf("\"error\": \"%s\"}", error);
+            continue;
+        }
+
+        json += msprintf("\"samples\": %s, \"iterations\": %s, \"min\": %s, \"median\": %s, "
+                         "\"mean\": %s, \"max\": %s, \"stages\": {",
+                         r.samples, r.iterations, r.min, r.median, r.mean, r.max);
+        for (size_t j = 0; j < r.stages.size(); ++j)
+            json += msprintf("%s\"%s\": %s", j == 0 ? "" : ", ", r.stages[j].first, r.stages[j].second);
+        json += "}}";
+    }
+    json += "\n  ]\n}\n";
+
+    return json;
+}
+
+/* static */ std::map<std::string, double> bench::load_baseline(
+                                                                const std::string& filename)
+{
+    static const string name_key = "{\"name\": \"";
+    static const string min_key = "\"min\": ";
+
+    ifstream in(filename);
+    if (!in)
+        throw io_exception("Baseline %s can not be opened", filename);
+
+    // report has one benchmark per line, failed ones have no times
+    map<string, double> baseline;
+    string line;
+    while (getline(in, line))
+    {
+        size_t name = line.find(name_key);
+        size_t minimum = line.find(min_key);
+        if (name == string::npos || minimum == string::npos)
+            continue;
+
+        name += name_key.size();
+        size_t name_end = line.find('"', name);
+        if (name_end == string::npos)
+            continue;
+        baseline[line.substr(name, name_end - name)] = atof(line.c_str() + minimum + min_key.size());
+    }
+
+    if (baseline.empty())
+        throw wrong_argument_exception("Baseline %s contains no benchmarks", filename);
+
+    return baseline;
+}
+
+/* static */ size_t bench::compare(
+                                   const results& res,
+                                   const std::map<std::string, double>& baseline,
+                                   double threshold)
+{
+    size_t regressions = 0;
+
+    fprintf(stderr, "\n%-48s %12s %12s %8s\n", "benchmark", "baseline", "current", "change");
+    for (const result& r : res)
+    {
+        auto it = baseline.find(r.name);
+        if (!r.error.empty() || it == baseline.end() || !(it->second > 0))
+        {
+            fprintf(stderr, "%-48s %12s %12s %8s\n", r.name.c_str(), "-", "-",
+                    r.error.empty() ? "new" : "failed");
+            continue;
+        }
+
+        double change = (r.min / it->second - 1) * 100;
+        bool regression = change > threshold;
+        if (regression)
+            ++regressions;
+        fprintf(stderr, "%-48s %12.6f %12.6f %+7.1f%%%s\n", r.name.c_str(),
+                it->second, r.min, change, regression ? " REGRESSION" : "");
+    }
+    fprintf(stderr, "%zu regressions over %g %%\n", regressions, threshold);
+
+    return regressions;
+}
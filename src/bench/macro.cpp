@@ -0,0 +1,115 @@
+/*
+ * File: macro.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include "bench.hpp"
+#include "traveler.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+namespace
+{
+    /**
+     * target laid out by template, as with `--all`
+     */
+    struct pair_input
+    {
+        string target;
+        string templated;
+        string templated_format;
+        string templated_image;
+    };
+
+    /**
+     * whole pipeline from reading files to documents in memory
+     */
+    void lay_out(
+                 const pair_input& p)
+    {
+        rna_tree templated = traveler::load_template(p.templated_image, p.templated_format, p.templated + ".fasta");
+        rna_tree target = traveler::build_target(read_fasta_file(p.target));
+
+        mapping m = traveler::compute_mapping(templated, target);
+        traveler::layout(templated, target, m, traveler::layout_options());
+
+        render_model model = traveler::get_render_model(templated, numbering_def(),
+                                                        traveler::find_overlaps(templated));
+        for (traveler::format_type format : {traveler::svg, traveler::ps, traveler::xml, traveler::json})
+            for (bool colored : {false, true})
+                traveler::render(templated, model, format, colored);
+    }
+}
+
+void bench::add_macro()
+{
+    // pairs of tests/run.sh
+    vector<vector<string>> tests = {
+        {"human", "fruit_fly", "crw", "ps"},
+        {"URS0000000306_562", "d.16.b.E.coli", "crw", "ps"},
+        {"URS00000B1E10_489619-d.16.b.B.japonicum", "d.16.b.B.japonicum", "crw", "ps"},
+        {"URS00000B9D9D_471852-d.5.b.A.madurae", "d.5.b.A.madurae", "crw", "ps"},
+        {"URS00000B14F2_575540-d.5.b.P.brasiliensis", "d.5.b.P.brasiliensis", "crw", "ps"},
+        {"URS000000C6FF_36873-d.16.b.Burkholderia.sp", "d.16.b.Burkholderia.sp", "crw", "ps"},
+        {"URS00000AA4F3_76731-d.16.b.Burkholderia.sp", "d.16.b.Burkholderia.sp", "crw", "ps"},
+        {"J01436.1456.1522", "RF00005_Eukaryota-5E6M", "varna", "svg"},
+        {"URS00008E3949_44689-DD_28S_3D", "DD_28S_3D", "traveler", "tr"},
+    };
+    for (const vector<string>& t : tests)
+    {
+        string templated = root + "/tests/data/tmp/" + t[1];
+        pair_input p = {root + "/tests/data/tgt/" + t[0] + ".fasta", templated, t[2], templated + "." + t[3]};
+        add("tests/" + t[0], true, [p]() -> body
+            {
+                return [p]() { lay_out(p); };
+            });
+    }
+
+    // 18S rRNA of each species laid out by its closest relative in the set
+    vector<pair<string, string>> metazoa = {
+        {"human", "rabbit"},
+        {"rabbit", "human"},
+        {"mouse", "rat"},
+        {"rat", "mouse"},
+        {"african_frog", "kenyan_frog"},
+        {"kenyan_frog", "african_frog"},
+        {"blue_mussel", "sea_scallop"},
+        {"sea_scallop", "blue_mussel"},
+        {"cicadas", "fruit_fly"},
+        {"fruit_fly", "cicadas"},
+        {"artemia_salina", "scorpion"},
+        {"scorpion", "artemia_salina"},
+        {"mnemiopsis_leidyi", "tripedalia_cystophora"},
+        {"tripedalia_cystophora", "mnemiopsis_leidyi"},
+        {"microciona_prolifera", "tripedalia_cystophora"},
+        {"echinococcus_granulosus", "blue_mussel"},
+    };
+    for (const auto& m : metazoa)
+    {
+        string templated = root + "/data/metazoa/" + m.second;
+        pair_input p = {root + "/data/metazoa/" + m.first + ".fasta", templated, "crw", templated + ".ps"};
+        add("metazoa/" + m.first + "-" + m.second, true, [p]() -> body
+            {
+                return [p]() { lay_out(p); };
+            });
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * File: main.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.hpp"
+#include "types.hpp"
+#include "utils.hpp"
+
+// regression is reported when benchmark is slower by more percent
+#define DEFAULT_THRESHOLD       10
+
+#ifndef BENCH_ROOT
+#define BENCH_ROOT              ".."
+#endif
+
+using namespace std;
+
+namespace
+{
+    void usage(
+               const string& appname)
+    {
+        cerr
+            << "usage: " << appname
+            << " [--micro|--macro] [--filter TEXT] [--repeat N] [--out FILE]" << endl
+            << "\t[--baseline FILE [--threshold PERCENT]] [--root DIR] [--list]" << endl
+            << endl
+            << "\t--micro, --macro\trun only microbenchmarks of stages or only whole pipeline" << endl
+            << "\t--filter TEXT\t\trun only benchmarks whose name contains TEXT" << endl
+            << "\t--repeat N\t\tsamples of each benchmark, default 5 for micro and 1 for macro" << endl
+            << "\t--out FILE\t\tsave JSON report to FILE instead of stdout" << endl
+            << "\t--baseline FILE\t\tcompare with report saved by --out, exits with 1 on regression" << endl
+            << "\t--threshold PERCENT\tslowdown reported as regression, default " << DEFAULT_THRESHOLD << endl
+            << "\t--root DIR\t\trepository with tests/data and data, default " << BENCH_ROOT << endl
+            << "\t--list\t\t\tprint names of benchmarks" << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    vector<string> args(argv, argv + argc);
+
+    bench::options opts;
+    string out, baseline, root = BENCH_ROOT;
+    double threshold = DEFAULT_THRESHOLD;
+    bool list = false;
+
+    try
+    {
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            if (args[i] == "--micro")
+                opts.macro = false;
+            else if (args[i] == "--macro")
+                opts.micro = false;
+            else if (args[i] == "--filter")
+                opts.filter = args.at(++i);
+            else if (args[i] == "--repeat")
+                opts.repeat = stoul(args.at(++i));
+            else if (args[i] == "--out")
+                out = args.at(++i);
+            else if (args[i] == "--baseline")
+                baseline = args.at(++i);
+            else if (args[i] == "--threshold")
+                threshold = stod(args.at(++i));
+            else if (args[i] == "--root")
+                root = args.at(++i);
+            else if (args[i] == "--list")
+                list = true;
+            else
+                throw wrong_argument_exception("Unknown argument %s", args[i]);
+        }
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        usage(args[0]);
+        return 2;
+    }
+
+    // logging would be measured with benchmarks
+    logger.set_priority(logger::EMERG);
+
+    bench b(root);
+    if (list)
+    {
+        for (const string& name : b.get_names())
+            cout << name << endl;
+        return 0;
+    }
+
+    try
+    {
+        map<string, double> base;
+        // baseline is read before benchmarks, so they are not run in vain
+        if (!baseline.empty())
+            base = bench::load_baseline(baseline);
+
+        bench::results res = b.run(opts);
+        string json = bench::to_json(res);
+        if (out.empty())
+            cout << json;
+        else
+            write_file(out, json);
+
+        size_t failed = 0;
+        for (const bench::result& r : res)
+            if (!r.error.empty())
+                ++failed;
+
+        size_t regressions = base.empty() ? 0 : bench::compare(res, base, threshold);
+        return failed == 0 && regressions == 0 ? 0 : 1;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
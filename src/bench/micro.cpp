@@ -0,0 +1,238 @@
+/*
+ * File: micro.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "traveler.hpp"
+#include "extractor.hpp"
+#include "rted.hpp"
+#include "gted.hpp"
+#include "tree_matcher.hpp"
+#include "compact.hpp"
+#include "utils.hpp"
+
+// 5S rRNA pair, TED of larger structures takes minutes
+#define TED_TEMPLATE            "/tests/data/tmp/d.5.b.A.madurae"
+#define TED_TARGET              "/tests/data/tgt/URS00000B14F2_575540-d.5.b.P.brasiliensis.fasta"
+// 16S rRNA template, for stages which need no mapping
+#define LARGE_TEMPLATE          "/tests/data/tmp/d.16.b.E.coli"
+#define VARNA_TEMPLATE          "/tests/data/tmp/RF00005_Eukaryota-5E6M.svg"
+#define TRAVELER_TEMPLATE       "/tests/data/tmp/DD_28S_3D.tr"
+
+using namespace std;
+
+namespace
+{
+    /**
+     * template, target and their mapping
+     */
+    struct ted_input
+    {
+        ted_input(
+                  const string& template_file,
+                  const string& target_file)
+            : templated(traveler::load_template(template_file + ".ps", "crw", template_file + ".fasta")),
+            target(traveler::build_target(read_fasta_file(target_file)))
+        {
+            m = traveler::compute_mapping(templated, target);
+        }
+
+        rna_tree templated;
+        rna_tree target;
+        mapping m;
+    };
+
+    /**
+     * laid out template with its document model
+     */
+    struct render_input
+    {
+        render_input(
+                     const string& template_file)
+            : rna(traveler::load_template(template_file + ".ps", "crw", template_file + ".fasta")),
+            model(traveler::get_render_model(rna, numbering_def()))
+        { }
+
+        rna_tree rna;
+        render_model model;
+    };
+
+    /**
+     * file removed with object
+     */
+    struct temp_file
+    {
+        string name;
+
+        ~temp_file()
+        {
+            remove(name.c_str());
+        }
+    };
+
+    /**
+     * returns function creating value by `make` on first call,
+     * later calls return the same value; inputs are shared by benchmarks
+     * and created only when a benchmark using them is run
+     */
+    template <typename T>
+    function<T&()> lazy(
+                        function<T*()> make)
+    {
+        auto value = make_shared<unique_ptr<T>>();
+        return [value, make]() -> T&
+        {
+            if (!*value)
+                value->reset(make());
+            return **value;
+        };
+    }
+}
+
+void bench::add_micro()
+{
+    string ted_template = root + TED_TEMPLATE;
+    string ted_target = root + TED_TARGET;
+    string large_template = root + LARGE_TEMPLATE;
+
+    auto ted = lazy<ted_input>([=]() { return new ted_input(ted_template, ted_target); });
+    auto large = lazy<render_input>([=]() { return new render_input(large_template); });
+    auto layout_file = lazy<temp_file>([=]()
+                                       {
+                                           temp_file* f = new temp_file{msprintf("/tmp/traveler_bench_%s.json", getpid())};
+                                           render_input& in = large();
+                                           write_file(f->name, traveler::render(in.rna, in.model, traveler::json, false));
+                                           return f;
+                                       });
+
+    // tree edit distance
+    add("rted strategy", false, [ted]() -> body
+        {
+            const ted_input& in = ted();
+            return [&in]()
+            {
+                rted r(in.templated, in.target);
+                r.run();
+            };
+        });
+    add("gted distance", false, [ted]() -> body
+        {
+            const ted_input& in = ted();
+            auto r = make_shared<rted>(in.templated, in.target);
+            r->run();
+            return [&in, r]()
+            {
+                gted g(in.templated, in.target);
+                g.run(r->get_strategies());
+            };
+        });
+    add("mapping extraction", false, [ted]() -> body
+        {
+            const ted_input& in = ted();
+            rted r(in.templated, in.target);
+            r.run();
+            auto g = make_shared<gted>(in.templated, in.target);
+            g->run(r.get_strategies());
+            return [g]()
+            {
+                g->get_mapping();
+            };
+        });
+
+    // layout
+    add("matcher", false, [ted]() -> body
+        {
+            const ted_input& in = ted();
+            return [&in]()
+            {
+                matcher(in.templated, in.target).run(in.m);
+            };
+        });
+    add("compact", false, [ted]() -> body
+        {
+            const ted_input& in = ted();
+            auto rna = make_shared<rna_tree>(matcher(in.templated, in.target).run(in.m));
+            return [rna]()
+            {
+                compact(*rna).run(false);
+            };
+        });
+    add("overlap checks", false, [large]() -> body
+        {
+            rna_tree& rna = large().rna;
+            return [&rna]()
+            {
+                overlap_checks().run(rna);
+            };
+        });
+
+    // extractors
+    vector<pair<string, string>> documents = {
+        {"crw", large_template + ".ps"},
+        {"varna", root + VARNA_TEMPLATE},
+        {"traveler", root + TRAVELER_TEMPLATE},
+    };
+    for (const auto& d : documents)
+    {
+        add("extract " + d.first, false, [d]() -> body
+            {
+                return [d]()
+                {
+                    extractor::get_extractor(d.second, d.first);
+                };
+            });
+    }
+    add("extract layout", false, [layout_file]() -> body
+        {
+            string file = layout_file().name;
+            return [file]()
+            {
+                extractor::get_extractor(file, "layout");
+            };
+        });
+
+    // writers
+    add("render model", false, [large]() -> body
+        {
+            rna_tree& rna = large().rna;
+            return [&rna]()
+            {
+                traveler::get_render_model(rna, numbering_def());
+            };
+        });
+    for (const char* format : {"svg", "ps", "xml", "json", "binary"})
+    {
+        traveler::format_type type = traveler::get_format(format);
+        add(string("write ") + format, false, [large, type]() -> body
+            {
+                render_input& in = large();
+                return [&in, type]()
+                {
+                    traveler::render(in.rna, in.model, type, true);
+                };
+            });
+    }
+}
@@ -6,7 +6,8 @@ LOG_FILE                = "/tmp/traveler.log"
 
 CC                      = g++
 DEBUG                   = -g -Wall
-CFLAGS                  = -std=gnu++11 -c ${DEBUG} ${RELEASE} -I${ROOTDIR}/include/ -I${ROOTDIR}/include/tests/ -DLOG_FILE=\\\"${LOG_FILE}\\\"
-LFLAGS                  = ${DEBUG} ${RELEASE} -std=c++11
+CFLAGS                  = -std=gnu++11 -c -pthread ${DEBUG} ${RELEASE} -I${ROOTDIR}/include/ -I${ROOTDIR}/include/tests/ -DLOG_FILE=\\\"${LOG_FILE}\\\"
+LFLAGS                  = ${DEBUG} ${RELEASE} -std=c++11 -pthread
+LIBS                    = -lz
 SHELL                   = /bin/bash -o pipefail
 
@@ -24,8 +24,10 @@
 #include "compact_utils.hpp"
 #include "overlap_checks.hpp"
 #include "tree_base.hpp"
+#include "profiler.hpp"
 
 #include "iostream"
+#include <chrono>
 
 using namespace std;
 
@@ -35,22 +37,31 @@ using namespace std;
 #define BASES_DISTANCE rna.get_pairs_distance()
 
 compact::compact(
-                 rna_tree& _rna)
-: rna(_rna)
+                 rna_tree& _rna,
+                 const layout_budget& _limits)
+: rna(_rna), limits(_limits)
 { }
 
 
 void compact::run(bool rotate_branches)
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("compact");
     
     INFO("BEG: Computing RNA layout for:\n%s", rna.print_tree(false));
     
+    dirty.assign(rna.size(), false);
+    processed.assign(rna.size(), false);
+    
     init();
     make();
     set_53_labels(rna);
     beautify(rotate_branches);
     checks();
+    
+    reuse.processed = count(processed.begin(), processed.end(), true);
+    reuse.reused = processed.size() - reuse.processed;
+    INFO("Layout nodes processed: %s, reused from template: %s", reuse.processed, reuse.reused);
 
     INFO("END: Computing RNA layout");
 }
@@ -167,7 +178,8 @@ void rotate_branch_by_angle(rna_tree &rna, rna_tree::iterator branch, double ang
 
     }
 
-    rna.update_bounding_boxes();
+    // only branch and its siblings were rotated
+    rna.update_bounding_boxes(parent);
 
 }
 
@@ -469,6 +481,7 @@ void init_root_level_unpaired(rna_tree &  rna){
 void compact::init()
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("compact init");
     
     assert(rna.is_ordered_postorder());
 
@@ -489,6 +502,8 @@ void compact::init()
     
     for (iterator it = ++rna.begin(); it != rna.end(); ++it)
     { //traverse the tree pre-order
+        if (!it->initiated_points())
+            dirty[it->id()] = processed[it->id()] = true;
         if (it->initiated_points() || !it->paired())
             continue;
         
@@ -531,28 +546,31 @@ void compact::init()
 //    straighten_branches();
 
     
-    auto log = logger.debug_stream();
-    log << "Points initialization:\n";
-    auto f = [&](pre_post_order_iterator it)
+    if (LOGGER_ENABLED(debug, DEBUG))
     {
-        if (it->paired())
+        auto log = logger.debug_stream();
+        log << "Points initialization:\n";
+        auto f = [&](pre_post_order_iterator it)
         {
-            if (it.preorder())
+            if (it->paired())
             {
-                mprintf("it[%s][%s = %s][%s = %s]\n", log,
+                if (it.preorder())
+                {
+                    mprintf("it[%s][%s = %s][%s = %s]\n", log,
+                            it->status,
+                            it->at(0).label, it->at(0).p,
+                            it->at(1).label, it->at(1).p);
+                }
+            }
+            else
+            {
+                mprintf("it[%s][%s = %s]\n", log,
                         it->status,
-                        it->at(0).label, it->at(0).p,
-                        it->at(1).label, it->at(1).p);
+                        it->at(0).label, it->at(0).p);
             }
-        }
-        else
-        {
-            mprintf("it[%s][%s = %s]\n", log,
-                    it->status,
-                    it->at(0).label, it->at(0).p);
-        }
-    };
-    rna_tree::for_each_in_subtree(rna.begin_pre_post(), f);
+        };
+        rna_tree::for_each_in_subtree(rna.begin_pre_post(), f);
+    }
     
     // if first node was inserted and it is only one branch - do not remake it
     // because it shares parents (3'5' node) position: 3'-NODE1 <-> NODE2-5'
@@ -1161,6 +1179,7 @@ void compact::straighten_branch(
 void compact::make()
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("compact make");
     
     iterator it;
     intervals in;
@@ -1178,7 +1197,11 @@ void compact::make()
         set_distances(in);
         for (auto& i : in.vec)
             if (i.remake)
+            {
+                for (const auto& n : i.vec)
+                    dirty[n->id()] = processed[n->id()] = true;
                 remake(i, in.get_circle_direction());
+            }
     }
 }
 
@@ -1374,9 +1397,9 @@ double compact::get_length(
     }
 }
 
-bool bo_overlap(vector<rectangle> vr1, vector<rectangle> vr2) {
-    for (rectangle r1: vr1) {
-        for (rectangle r2: vr2){
+bool bo_overlap(const vector<rectangle>& vr1, const vector<rectangle>& vr2) {
+    for (const rectangle& r1: vr1) {
+        for (const rectangle& r2: vr2){
             if (r1.intersects(r2)){
                 return true;
             }
@@ -1386,8 +1409,8 @@ bool bo_overlap(vector<rectangle> vr1, vector<rectangle> vr2) {
     return false;
 }
 
-bool bo_overlap(vector<rectangle> rs, point line_begin, point line_end) {
-    for (rectangle r: rs) {
+bool bo_overlap(const vector<rectangle>& rs, const point& line_begin, const point& line_end) {
+    for (const rectangle& r: rs) {
         if (r.intersects(line_begin, line_end)) {
             return true;
         }
@@ -1483,7 +1506,7 @@ bool vec_closer_to_axis(const point vec1, const point vec2){
 
 }
 
-void reposition_branch(rna_tree &rna, rna_tree::post_order_iterator it, rna_tree::iterator root) {
+bool reposition_branch(rna_tree &rna, rna_tree::post_order_iterator it, rna_tree::iterator root) {
 
     std::vector<int> angles;
     int ix_zero_angle = -1;
@@ -1500,7 +1523,7 @@ void reposition_branch(rna_tree &rna, rna_tree::post_order_iterator it, rna_tree
 
     //Try to rotate only if substantial portion of the tree overlaps
 
-    if (cnt_overlaps_min < rna.size(it) * 0.2) return;
+    if (cnt_overlaps_min < rna.size(it) * 0.2) return false;
 
     int ix_angle_min = ix_zero_angle, ix_mirror_min = 0, ix_mirror = 0;
 
@@ -1549,7 +1572,9 @@ void reposition_branch(rna_tree &rna, rna_tree::post_order_iterator it, rna_tree
     {
         if (ix_mirror_min == 1) mirror_branch(it);
         rotate_branch_by_angle(rna, it, angles[ix_angle_min]);
+        return true;
     }
+    return false;
 }
 
 int number_of_non_leaf_children(rna_tree::iterator it) {
@@ -1571,17 +1596,104 @@ bool is_repositionable(const rna_tree::iterator it) {
 }
 
 
-void compact::reposition_branches() {
+size_t compact::reposition_branches() {
+
+    size_t moved = 0;
 
     rna.update_bounding_boxes();
+    update_dirty();
 
     for (auto it = rna.begin_post(); it != rna.end_post(); ++it){
-        if (is_repositionable(it)) {
-            reposition_branch(rna, it, rna.begin());
+        if (!is_repositionable(it) || !in_dirty_region(it))
+            continue;
+
+        set_subtree(processed, it);
+        if (reposition_branch(rna, it, rna.begin())) {
+            ++moved;
+            add_dirty(it);
         }
     }
 
     set_53_labels(rna);
+
+    return moved;
+}
+
+void compact::update_dirty()
+{
+    dirty_nodes.clear();
+    dirty_subtree.assign(dirty.size(), false);
+
+    for (post_order_iterator it = rna.begin_post(); it != rna.end_post(); ++it)
+        if (dirty[it->id()])
+            mark_dirty(it);
+
+    index_dirty();
+}
+
+void compact::add_dirty(
+                        iterator it)
+{
+    post_order_iterator ch = it;
+    post_order_iterator end = it;
+    ++end;
+    ch.descend_all();
+    for (; ch != end; ++ch)
+        if (!dirty[ch->id()])
+        {
+            dirty[ch->id()] = true;
+            mark_dirty(ch);
+        }
+
+    // branch was rotated with its siblings, so also positions
+    // of dirty nodes which were there before changed
+    index_dirty();
+}
+
+void compact::mark_dirty(
+                         iterator it)
+{
+    dirty_nodes.push_back(it);
+    for (; !dirty_subtree[it->id()]; it = rna_tree::parent(it))
+    {
+        dirty_subtree[it->id()] = true;
+        if (rna_tree::is_root(it))
+            break;
+    }
+}
+
+void compact::index_dirty()
+{
+    vector<point> points;
+    for (iterator it : dirty_nodes)
+        for (size_t i = 0; i < it->size(); ++i)
+            if (!it->at(i).p.bad())
+                points.push_back(it->at(i).p);
+
+    dirty_index = spatial_index(points, {}, 2 * BASES_DISTANCE);
+}
+
+bool compact::in_dirty_region(
+                              iterator it) const
+{
+    if (dirty_subtree[it->id()])
+        return true;
+
+    for (const rectangle& bo : it->get_bounding_objects())
+        if (dirty_index.any_point(bo))
+            return true;
+
+    return false;
+}
+
+void compact::set_subtree(
+                          std::vector<bool>& flags,
+                          iterator it)
+{
+    // postorder ids of subtree are consecutive, ending with `it`
+    size_t last = it->id();
+    size_t first = last + 1 - rna.size(it);
+    fill(flags.begin() + first, flags.begin() + last + 1, true);
 }
 
 void contract_nodes(compact::iterator it, compact::iterator it2, compact::iterator root) {
@@ -1592,8 +1704,11 @@ void contract_nodes(compact::iterator it, compact::iterator it2, compact::iterat
  * Deletion of a node (unpaired nt) introduces a gap in the layout. This is taken care of in the case of in non-root
  * level. This function does the contraction for the first level.
  * @param rna
+ * @return number of kept contractions
  */
-void contract_root_level(rna_tree &  rna) {
+size_t contract_root_level(rna_tree &  rna) {
+
+    size_t moved = 0;
 
     rna.update_bounding_boxes();
 
@@ -1637,7 +1752,7 @@ void contract_root_level(rna_tree &  rna) {
 //                        shift_region(it, end,  dist_vect);
                         rna.update_bounding_boxes();
                     } else {
-//                        return;
+                        ++moved;
                     }
                 }
 //            }
@@ -1646,25 +1761,66 @@ void contract_root_level(rna_tree &  rna) {
 
         it++; it_prev++;
     }
+
+    return moved;
 }
 
 void compact::beautify(bool rotate_branches){
+    PROFILE_STAGE("beautify");
 
     INFO("BEGIN: beautification");
+    stats.clear();
     if (!rotate_branches) {
         contract_root_level(rna);
     } else {
-        //TODO: number of iterations needs to be parametrized
-        for (int i = 0; i < 3; ++i) {
-            contract_root_level(rna);
-            reposition_branches();
-        }
+        run_rounds([this]() { return contract_root_level(rna) + reposition_branches(); },
+                   [this]() { return overlap_checks().run(rna).size(); });
     }
 
     set_53_labels(rna);
     INFO("END: beautification");
 }
 
+void compact::run_rounds(
+                         const std::function<size_t()>& round,
+                         const std::function<size_t()>& count_overlaps)
+{
+    typedef chrono::steady_clock clock;
+    auto seconds_since = [](clock::time_point from) {
+        return chrono::duration<double>(clock::now() - from).count();
+    };
+
+    clock::time_point start = clock::now();
+    size_t overlaps_prev = count_overlaps();
+
+    for (size_t i = 0; limits.max_iterations == 0 || i < limits.max_iterations; ++i) {
+        clock::time_point iteration_start = clock::now();
+        rna_tree previous = rna;
+
+        size_t moved = round();
+        size_t overlaps = count_overlaps();
+        bool reverted = overlaps > overlaps_prev;
+
+        stats.push_back({overlaps, moved, seconds_since(iteration_start), reverted});
+        INFO("Beautification iteration %s: overlaps %s, moved branches %s, time %s s",
+             i + 1, overlaps, moved, stats.back().time);
+
+        if (reverted) {
+            INFO("Beautification iteration %s increased overlaps, reverting it", i + 1);
+            rna = previous;
+        }
+        if (moved == 0 || overlaps >= overlaps_prev) {
+            INFO("Beautification converged after %s iterations", i + 1);
+            break;
+        }
+        if (limits.time > 0 && seconds_since(start) >= limits.time) {
+            INFO("Beautification time budget %s s exhausted after %s iterations", limits.time, i + 1);
+            break;
+        }
+        overlaps_prev = overlaps;
+    }
+}
+
 
 
 //std::vector<int> get_ixs_of_distinct_edges(overlap_checks::edges es1, overlap_checks::edges es2) {
@@ -21,6 +21,8 @@
 
 #include "overlap_checks.hpp"
 #include "rna_tree.hpp"
+#include "rectangle.hpp"
+#include "profiler.hpp"
 
 using namespace std;
 
@@ -33,12 +35,14 @@ overlap_checks::overlaps overlap_checks::run(
                                              rna_tree& rna)
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("overlap checks");
     
     INFO("BEG: Checking overlaps for RNA %s", rna.name());
     
     edges vec = get_edges(rna);
     overlaps overlaps = run(vec);
-    //overlaps overlaps = get_overlaps(vec, vec);
+    
+    INFO("END: Checking overlaps for RNA %s", rna.name());
     
     return overlaps;
 }
@@ -81,114 +85,146 @@ overlap_checks::overlaps overlap_checks::run(
 {
     APP_DEBUG_FNAME;
     
-    edge e1, e2;
-    point p;
-    vector<overlapping> vec;
+    // edges are bucketed into uniform grid, only edges sharing a cell
+    // are tested against each other; results are reported in the same
+    // (i, j) order as a full pairwise scan would produce them
+    struct found
+    {
+        size_t i, j;
+        overlapping o;
+    };
+    
+    vector<found> vec;
     
-    for (size_t i = 0; i < e.size(); ++i)
+    if (e.size() < 3)
+        return overlaps();
+    
+    vector<rectangle> boxes;
+    rectangle all;
+    double length = 0;
+    
+    boxes.reserve(e.size());
+    for (const edge& ed : e)
     {
-        e1 = e[i];
-        
-        for (size_t j = i + 2; j < e.size(); ++j)
+        boxes.emplace_back(ed.p1, ed.p2);
+        all += boxes.back();
+        length += distance(ed.p1, ed.p2);
+    }
+    
+    // cell size ~ average edge length, number of cells bounded by #edges
+    point dim = all.get_bottom_right() - all.get_top_left();
+    double width = max(fabs(dim.x), 1.);
+    double height = max(fabs(dim.y), 1.);
+    double cell = max({length / e.size(),
+                       sqrt(width * height / e.size()),
+                       max(width, height) / e.size()});
+    if (iszero(cell, false))
+        cell = 1;
+    size_t columns = size_t(width / cell) + 1;
+    size_t rows = size_t(height / cell) + 1;
+    
+    auto column =
+    [&](double x)
+    {
+        return min(columns - 1, size_t((x - all.top_left.x) / cell));
+    };
+    auto row =
+    [&](double y)
+    {
+        return min(rows - 1, size_t((y - all.bottom_right.y) / cell));
+    };
+    
+    // cells[first[c] .. first[c + 1]) are edges registered in cell c
+    vector<size_t> first(columns * rows + 1, 0);
+    vector<size_t> cells;
+    
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        vector<size_t> fill;
+        if (pass == 1)
         {
-            e2 = e[j];
-
-            if (e1 == e2 || e1.share_point(e2)) continue;
-            
-            p = intersection(e1, e2);
-            
-            if (!p.bad())
+            for (size_t c = 1; c < first.size(); ++c)
+                first[c] += first[c - 1];
+            cells.resize(first.back());
+            fill.assign(first.begin(), first.end() - 1);
+        }
+        for (size_t i = 0; i < e.size(); ++i)
+        {
+            const rectangle& b = boxes[i];
+            for (size_t x = column(b.top_left.x); x <= column(b.bottom_right.x); ++x)
+                for (size_t y = row(b.bottom_right.y); y <= row(b.top_left.y); ++y)
+                {
+                    size_t c = y * columns + x;
+                    if (pass == 0)
+                        ++first[c + 1];
+                    else
+                        cells[fill[c]++] = i;
+                }
+        }
+    }
+    
+    for (size_t c = 0; c + 1 < first.size(); ++c)
+    {
+        for (size_t k = first[c]; k < first[c + 1]; ++k)
+        {
+            for (size_t l = k + 1; l < first[c + 1]; ++l)
             {
-                auto distances = {
-                    distance(p, e1.p1),
-                    distance(p, e1.p2),
-                    distance(p, e2.p1),
-                    distance(p, e2.p2),
-                };
-                double radius = *std::max_element(distances.begin(), distances.end());
-                vec.push_back({p, radius});
+                size_t i = min(cells[k], cells[l]);
+                size_t j = max(cells[k], cells[l]);
+                
+                if (j < i + 2 || !boxes[i].intersects(boxes[j]))
+                    continue;
+                
+                // pair is reported only from the cell which contains
+                // the lower left corner of bounding boxes intersection
+                double x = max(boxes[i].top_left.x, boxes[j].top_left.x);
+                double y = max(boxes[i].bottom_right.y, boxes[j].bottom_right.y);
+                if (row(y) * columns + column(x) != c)
+                    continue;
+                
+                edge e1 = e[i];
+                edge e2 = e[j];
+                
+                if (e1 == e2 || e1.share_point(e2))
+                    continue;
+                
+                point p = intersection(e1, e2);
+                
+                if (!p.bad())
+                {
+                    auto distances = {
+                        distance(p, e1.p1),
+                        distance(p, e1.p2),
+                        distance(p, e2.p1),
+                        distance(p, e2.p2),
+                    };
+                    double radius = *std::max_element(distances.begin(), distances.end());
+                    vec.push_back({i, j, {p, radius}});
+                }
             }
         }
     }
     
-    return vec;
-}
-
-bool onLine(overlap_checks::edge l1, point p) {   //check whether p is on the line or not
-    if(p.x <= max(l1.p1.x, l1.p2.x) && p.x <= min(l1.p1.x, l1.p2.x) &&
-       (p.y <= max(l1.p1.y, l1.p2.y) && p.y <= min(l1.p1.y, l1.p2.y)))
-        return true;
-
-    return false;
-}
-
-int direction(point a, point b, point c) {
-    int val = (b.y-a.y)*(c.x-b.x)-(b.x-a.x)*(c.y-b.y);
-    if (val == 0)
-        return 0;     //colinear
-    else if(val < 0)
-        return 2;    //anti-clockwise direction
-    return 1;    //clockwise direction
+    sort(vec.begin(), vec.end(),
+         [](const found& f1, const found& f2)
+         {
+             return f1.i < f2.i || (f1.i == f2.i && f1.j < f2.j);
+         });
+    
+    overlaps out;
+    out.reserve(vec.size());
+    for (const found& f : vec)
+        out.push_back(f.o);
+    
+    return out;
 }
 
-//point overlap_checks::intersection(const edge& l1, const edge& l2) {
-//    //four direction for two lines and points of other line
-//    int dir1 = direction(l1.p1, l1.p2, l2.p1);
-//    int dir2 = direction(l1.p1, l1.p2, l2.p2);
-//    int dir3 = direction(l2.p1, l2.p2, l1.p1);
-//    int dir4 = direction(l2.p1, l2.p2, l1.p2);
-//
-//    if(dir1 != dir2 && dir3 != dir4)
-//        return point(0,0); //they are intersecting
-//
-//    if(dir1==0 && onLine(l1, l2.p1)) //when p2 of line2 are on the line1
-//        return point(0,0);
-//
-//    if(dir2==0 && onLine(l1, l2.p2)) //when p1 of line2 are on the line1
-//        return point(0,0);
-//
-//    if(dir3==0 && onLine(l2, l1.p1)) //when p2 of line1 are on the line2
-//        return point(0,0);
-//
-//    if(dir4==0 && onLine(l2, l1.p2)) //when p1 of line1 are on the line2
-//        return point(0,0);
-//
-//    return point::bad_point();
-//}
-
-//point overlap_checks::intersection(const edge& e1, const edge& e2)
-//{
-//    float p0_x = e1.p1.x, p0_y = -e1.p1.y, p1_x = e1.p2.x, p1_y = -e1.p2.y;
-//    float p2_x = e2.p1.x, p2_y = -e2.p1.y, p3_x = e2.p2.x, p3_y = -e1.p1.y;
-//
-//    float s1_x, s1_y, s2_x, s2_y;
-//    s1_x = p1_x - p0_x;     s1_y = p1_y - p0_y;
-//    s2_x = p3_x - p2_x;     s2_y = p3_y - p2_y;
-//
-//    float s, t;
-//    s = (-s1_y * (p0_x - p2_x) + s1_x * (p0_y - p2_y)) / (-s2_x * s1_y + s1_x * s2_y);
-//    t = ( s2_x * (p0_y - p2_y) - s2_y * (p0_x - p2_x)) / (-s2_x * s1_y + s1_x * s2_y);
-//
-//    if (s >= 0 && s <= 1 && t >= 0 && t <= 1)
-//    {
-//        // Collision detected
-//        return point(p0_x + (t * s1_x), p0_y + (t * s1_y));
-//    }
-//
-//    return point::bad_point(); // No collision
-//}
-
 /* static */ point overlap_checks::intersection(
                                                 const edge& e1,
                                                 const edge& e2)
 {
-    // a / sin(alpha) == b / sin(beta) == c / sin(gamma)
-    // => a = c * sin(alpha) / sin(gamma)
-    //
-    double alpha, beta, gamma;
-    double a, c;
     point p;
-
+    
     int cnt_ends_meet = 0;
     if (contains<vector<point>>({e1.p1, e1.p2}, e2.p1)) {
         p = e2.p1;
@@ -198,44 +234,44 @@ int direction(point a, point b, point c) {
         p = e2.p2;
         cnt_ends_meet++;
     }
-
+    
     if (cnt_ends_meet == 1) {
         return  p;
     } else if (cnt_ends_meet  == 2){
         return point::bad_point();
     }
-
-
-    c = distance(e1.p1, e2.p1);
-
-    alpha = angle(e2.p1, e1.p1, e1.p2);
-    beta = angle(e1.p1, e2.p1, e2.p2);
-
-    if (alpha > 180)
-        alpha = 360. - alpha;
-    if (beta > 180)
-        beta = 360. - beta;
-
-    gamma = 180. - alpha - beta;
-
-    assert(double_equals(180, alpha + beta + gamma));
-
-    if (gamma < 0 || iszero(gamma))
-        return point::bad_point();
-
-    a = c * radians_to_degrees(sin(degrees_to_radians(alpha))) /
-    radians_to_degrees(sin(degrees_to_radians(gamma)));
-
-    if (!iszero(a))
-        p = move_point(e2.p1, e2.p2, a);
-    else
-        p = e2.p1;
-
-    if (lies_between(p, e1.p1, e1.p2) &&
-        lies_between(p, e2.p1, e2.p2))
-        return p;
-    else
+    
+    int o1 = ccw(e1.p1, e1.p2, e2.p1);
+    int o2 = ccw(e1.p1, e1.p2, e2.p2);
+    int o3 = ccw(e2.p1, e2.p2, e1.p1);
+    int o4 = ccw(e2.p1, e2.p2, e1.p2);
+    
+    auto on_segment =
+    [](const point& p, const edge& e)
+    {
+        return min(e.p1.x, e.p2.x) <= p.x && p.x <= max(e.p1.x, e.p2.x) &&
+        min(e.p1.y, e.p2.y) <= p.y && p.y <= max(e.p1.y, e.p2.y);
+    };
+    
+    // endpoint touching other edge or collinear overlapping edges
+    if (o1 == 0 && on_segment(e2.p1, e1))
+        return e2.p1;
+    if (o2 == 0 && on_segment(e2.p2, e1))
+        return e2.p2;
+    if (o3 == 0 && on_segment(e1.p1, e2))
+        return e1.p1;
+    if (o4 == 0 && on_segment(e1.p2, e2))
+        return e1.p2;
+    
+    if (o1 * o2 >= 0 || o3 * o4 >= 0)
         return point::bad_point();
+    
+    // proper crossing: e1.p1 + t * (e1.p2 - e1.p1)
+    point r = e1.p2 - e1.p1;
+    point s = e2.p2 - e2.p1;
+    double t = cross(e2.p1 - e1.p1, s) / cross(r, s);
+    
+    return e1.p1 + r * t;
 }
 
 
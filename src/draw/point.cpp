@@ -327,6 +327,32 @@ bool lies_between(point p, point from, point to)
     double_equals(p.x / to.x, p.y / to.y);
 }
 
+double cross(const point& p1, const point& p2)
+{
+    BINARY(p1, p2);
+    
+    return p1.x * p2.y - p1.y * p2.x;
+}
+
+int ccw(const point& p1, const point& p2, const point& p3)
+{
+    BINARY(p1, p2);
+    UNARY(p3);
+    
+    // determinant is trusted only if it exceeds its rounding error bound
+    // (static filter from Shewchuk's robust predicates)
+    double left = (p2.x - p1.x) * (p3.y - p1.y);
+    double right = (p2.y - p1.y) * (p3.x - p1.x);
+    double det = left - right;
+    double bound = 3.3306690738754716e-16 * (fabs(left) + fabs(right));
+    
+    if (det > bound)
+        return 1;
+    if (-det > bound)
+        return -1;
+    return 0;
+}
+
 point abs(const point& p)
 {
     UNARY(p);
@@ -0,0 +1,121 @@
+/*
+ * File: spatial_index.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#include <cmath>
+#include "spatial_index.hpp"
+
+using namespace std;
+
+spatial_index::spatial_index(
+                             const std::vector<point>& _points,
+                             const std::vector<line>& _lines,
+                             double _cell)
+{
+    vector<rectangle> point_boxes, line_boxes;
+    rectangle all;
+
+    for (const point& p : _points)
+    {
+        if (p.bad())
+            continue;
+        points.push_back(p);
+        point_boxes.emplace_back(p, p);
+        all += point_boxes.back();
+    }
+    for (const line& l : _lines)
+    {
+        if (l.first.bad() || l.second.bad())
+        {
+            unbounded.push_back(l);
+            continue;
+        }
+        lines.push_back(l);
+        line_boxes.emplace_back(l.first, l.second);
+        all += line_boxes.back();
+    }
+
+    if (!all.initiated())
+        return;
+
+    // number of cells is bounded by number of indexed items
+    size_t items = points.size() + lines.size();
+    point dim = all.get_bottom_right() - all.get_top_left();
+    double width = max(fabs(dim.x), 1.);
+    double height = max(fabs(dim.y), 1.);
+
+    cell = max(_cell, sqrt(width * height / items));
+    if (!(cell > 0))
+        cell = 1;
+    origin = point(all.top_left.x, all.bottom_right.y);
+    columns = size_t(width / cell) + 1;
+    rows = size_t(height / cell) + 1;
+
+    fill(points_grid, point_boxes);
+    fill(lines_grid, line_boxes);
+}
+
+void spatial_index::fill(
+                         grid& g,
+                         const std::vector<rectangle>& boxes) const
+{
+    g.first.assign(columns * rows + 1, 0);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        vector<size_t> next;
+        if (pass == 1)
+        {
+            for (size_t c = 1; c < g.first.size(); ++c)
+                g.first[c] += g.first[c - 1];
+            g.items.resize(g.first.back());
+            next.assign(g.first.begin(), g.first.end() - 1);
+        }
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            const rectangle& b = boxes[i];
+            for (size_t y = row(b.bottom_right.y); y <= row(b.top_left.y); ++y)
+                for (size_t x = column(b.top_left.x); x <= column(b.bottom_right.x); ++x)
+                {
+                    size_t c = y * columns + x;
+                    if (pass == 0)
+                        ++g.first[c + 1];
+                    else
+                        g.items[next[c]++] = i;
+                }
+        }
+    }
+}
+
+size_t spatial_index::column(
+                             double x) const
+{
+    if (!(x > origin.x))
+        return 0;
+    return size_t(min(double(columns - 1), (x - origin.x) / cell));
+}
+
+size_t spatial_index::row(
+                          double y) const
+{
+    if (!(y > origin.y))
+        return 0;
+    return size_t(min(double(rows - 1), (y - origin.y) / cell));
+}
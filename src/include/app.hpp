@@ -26,6 +26,7 @@
 
 class rna_tree;
 class mapping;
+struct fasta;
 
 /**
  * class to handle flow
@@ -35,6 +36,18 @@ class app
 private:
     struct arguments;
     
+public:
+    /**
+     * one line of batch manifest
+     */
+    struct batch_job
+    {
+        size_t line;
+        std::vector<std::string> templated; // template files and format or bundle file
+        std::string targets;
+        std::string file;
+    };
+    
 public:
     /**
      * run app with arguments from command line
@@ -50,6 +63,14 @@ public:
     static void usage(
                       const std::string& appname = "");
     
+    /**
+     * parse batch manifest read from `in`, skipping empty lines
+     * and # comments, `name` is used in error messages
+     */
+    static std::vector<batch_job> read_batch_manifest(
+                                                      std::istream& in,
+                                                      const std::string& name);
+    
 private:
     /**
      * run with handled command line arguments
@@ -57,14 +78,54 @@ private:
     void run(
              arguments args);
     
+    /**
+     * run all jobs from batch manifest on pool of threads
+     */
+    void run_batch(
+                   const arguments& args);
+    
+    /**
+     * prepare template from command line arguments following
+     * compile-template and save it as template bundle
+     */
+    void compile_template(
+                          const std::vector<std::string>& args);
+    
+    /**
+     * run layout server with arguments following serve
+     */
+    void serve(
+               const std::vector<std::string>& args);
+    
+    /**
+     * lay out target structure `target`, `number`-th in targets file,
+     * against template
+     */
+    void run_target(
+                    const arguments& args,
+                    const fasta& target,
+                    size_t number,
+                    bool multiple);
+    
+    /**
+     * returns output file name of `number`-th target with `id`;
+     * "{id}" and "{n}" in `pattern` are replaced by them, if there are
+     * `multiple` targets and pattern has none of them, ".{n}" is appended
+     */
+    static std::string get_output_name(
+                                       const std::string& pattern,
+                                       const std::string& id,
+                                       size_t number,
+                                       bool multiple);
+    
     /**
      * run tree-edit-distance algorithm
-     * returns mapping between templated (template) and matched (target) tree
+     * returns mapping between templated (template) and matched (target) tree,
+     * it is saved to `mapping_file` too if it is not empty
      */
     mapping run_ted(
                     rna_tree& templated,
                     rna_tree& matched,
-                    bool save,
                     const std::string& mapping_file);
     
     /**
@@ -77,24 +138,30 @@ private:
                      bool run,
                      bool run_overlaps,
                      bool rotate_branches,
+                     const layout_budget& layout,
                      const std::string& file,
-                     const numbering_def& numbering);
+                     const numbering_def& numbering,
+                     bool compress,
+                     bool binary_layout);
     
     /**
-     * save both, colored and not colored documents
+     * save both, colored and not colored documents,
+     * gzip compressed when `compress` is set
      */
     void save(
               const std::string& filename,
               rna_tree& rna,
               bool overlaps,
-              const numbering_def& numbering);
+              const numbering_def& numbering,
+              bool compress,
+              bool binary_layout);
     
 private:
     /**
-     * reads both seq & fold file and construct rna tree
+     * construct rna tree of target structure
      */
     static rna_tree create_matched(
-                                   const std::string& fastafile);
+                                   const fasta& target);
     
     /**
      * reads ps & fold file and construct rna tree
@@ -0,0 +1,149 @@
+/*
+ * File: bench.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * runs benchmarks of traveler_bench and reports their times;
+ * microbenchmarks time one stage of the pipeline on fixed inputs,
+ * macrobenchmarks run the whole pipeline on template/target pairs
+ */
+class bench
+{
+public:
+    /**
+     * timed part of benchmark
+     */
+    typedef std::function<void()> body;
+    /**
+     * untimed preparation of one run, returns its body;
+     * it is called before every run, so body can modify what it prepared
+     */
+    typedef std::function<body()> setup;
+
+    struct options
+    {
+        // only benchmarks whose name contains filter are run
+        std::string filter;
+        bool micro = true;
+        bool macro = true;
+        // samples taken of each benchmark, 0 is default of its kind
+        size_t repeat = 0;
+        // minimal time of one microbenchmark sample, seconds
+        double min_sample = 0.05;
+    };
+
+    struct result
+    {
+        std::string name;
+        size_t samples = 0;
+        // runs of body in one sample
+        size_t iterations = 0;
+        // seconds of one run of body, over samples
+        double min = 0;
+        double median = 0;
+        double mean = 0;
+        double max = 0;
+        // mean seconds of profiled stages entered by one run
+        std::vector<std::pair<std::string, double>> stages;
+        // non-empty if benchmark failed
+        std::string error;
+    };
+    typedef std::vector<result> results;
+
+public:
+    /**
+     * registers benchmarks, data are read from repository `root`
+     */
+    bench(
+          const std::string& root);
+
+    /**
+     * runs selected benchmarks, progress is written to stderr
+     */
+    results run(
+                const options& opts) const;
+
+    std::vector<std::string> get_names() const;
+
+public:
+    /**
+     * report of `res`, one benchmark per line
+     */
+    static std::string to_json(
+                               const results& res);
+
+    /**
+     * reads minimal times of benchmarks from report written by `to_json`
+     */
+    static std::map<std::string, double> load_baseline(
+                                                       const std::string& filename);
+
+    /**
+     * compares minimal times of `res` with `baseline`, as noise only slows
+     * runs down; benchmarks slower by more than `threshold` percent
+     * are regressions. Writes comparison to stderr, returns number of regressions
+     */
+    static size_t compare(
+                          const results& res,
+                          const std::map<std::string, double>& baseline,
+                          double threshold);
+
+private:
+    struct benchmark
+    {
+        std::string name;
+        bool macro;
+        setup prepare;
+    };
+
+    void add(
+             const std::string& name,
+             bool macro,
+             setup prepare);
+
+    /**
+     * microbenchmarks of single stages
+     */
+    void add_micro();
+    /**
+     * whole pipeline on pairs of tests/data/tmp and data/metazoa
+     */
+    void add_macro();
+
+    result measure(
+                   const benchmark& b,
+                   const options& opts) const;
+
+private:
+    std::string root;
+    std::vector<benchmark> benchmarks;
+};
+
+#endif /* !BENCH_HPP */
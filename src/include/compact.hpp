@@ -22,7 +22,10 @@
 #ifndef COMPACT_HPP
 #define COMPACT_HPP
 
+#include <functional>
+
 #include "rna_tree.hpp"
+#include "spatial_index.hpp"
 
 class compact
 {
@@ -33,6 +36,15 @@ public:
     struct intervals;
     struct interval;
     
+    /**
+     * loop of beautify: runs `round` returning number of moved branches
+     * until overlaps counted by `count_overlaps` stop decreasing, no branch
+     * moves or `limits` are reached; round increasing overlaps is reverted
+     */
+    void run_rounds(
+                    const std::function<size_t()>& round,
+                    const std::function<size_t()>& count_overlaps);
+    
 public:
     typedef rna_tree::iterator                  iterator;
     typedef rna_tree::post_order_iterator       post_order_iterator;
@@ -41,9 +53,32 @@ public:
     typedef std::vector<point>                  points_vec;
     typedef std::vector<sibling_iterator>       nodes_vec;
     
+    /**
+     * statistics of one beautification iteration
+     */
+    struct iteration_stats
+    {
+        size_t overlaps;        // overlaps after the iteration
+        size_t moved_branches;  // contracted + repositioned branches
+        double time;            // seconds
+        bool reverted;          // iteration increased overlaps and was undone
+    };
+    typedef std::vector<iteration_stats>        stats_vec;
+    
+    /**
+     * number of nodes whose layout was recomputed
+     * and of nodes which kept template layout
+     */
+    struct reuse_stats
+    {
+        size_t processed = 0;
+        size_t reused = 0;
+    };
+    
 public:
     compact(
-            rna_tree& _rna);
+            rna_tree& _rna,
+            const layout_budget& _limits = layout_budget());
     
     /**
      * run compact algorithm.
@@ -52,6 +87,22 @@ public:
      */
     void run(bool rotate_branches);
     
+    /**
+     * returns statistics of beautification iterations of last run
+     */
+    inline const stats_vec& get_stats() const
+    {
+        return stats;
+    }
+    
+    /**
+     * returns processed/reused nodes counts of last run
+     */
+    inline const reuse_stats& get_reuse_stats() const
+    {
+        return reuse;
+    }
+    
 private:
     /**
      * sets distance between `parent` and `child`
@@ -232,11 +283,62 @@ private:
      */
     inline void checks();
 
+    /**
+     * repeat contraction and repositioning of branches
+     * until overlaps stop decreasing or `limits` are reached
+     */
     void beautify(bool rotate_branches);
     
 //    void try_reposition_new_root_branches();
 
-    void reposition_branches();
+    /**
+     * returns number of repositioned branches,
+     * only branches in dirty regions are tried
+     */
+    size_t reposition_branches();
+    
+private:
+    // DIRTY REGIONS functions:
+    /**
+     * recompute dirty subtrees and index of dirty points,
+     * dirty nodes are those whose layout was computed here
+     * instead of taken from template (inserted, remade, repositioned)
+     */
+    void update_dirty();
+
+    /**
+     * marks subtree of repositioned branch `it` dirty, updates
+     * only ancestors of new dirty nodes instead of whole tree
+     */
+    void add_dirty(
+                   iterator it);
+
+    /**
+     * appends dirty node `it` and marks its ancestors
+     * as having dirty subtree
+     */
+    void mark_dirty(
+                    iterator it);
+
+    /**
+     * rebuild spatial index of points of dirty nodes
+     */
+    void index_dirty();
+    
+    /**
+     * returns if branch `it` has dirty node in subtree
+     * or overlaps any dirty node
+     */
+    bool in_dirty_region(
+                         iterator it) const;
+    
+    /**
+     * set `flags` of all nodes in subtree of `it`
+     */
+    void set_subtree(
+                     std::vector<bool>& flags,
+                     iterator it);
+    // DIRTY REGIONS ^^
 
 //    void pull_neighbors_together();
     
@@ -249,6 +351,15 @@ private:
     
 private:
     rna_tree &  rna;
+    layout_budget limits;
+    stats_vec stats;
+    reuse_stats reuse;
+    
+    std::vector<bool> dirty;        // indexed by node id
+    std::vector<bool> dirty_subtree;
+    std::vector<bool> processed;
+    std::vector<iterator> dirty_nodes;
+    spatial_index dirty_index;
 };
 
 #endif /* !COMPACT_HPP */
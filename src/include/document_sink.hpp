@@ -0,0 +1,110 @@
+/*
+ * File: document_sink.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef DOCUMENT_SINK_HPP
+#define DOCUMENT_SINK_HPP
+
+#include <string>
+
+/**
+ * append-only text buffer documents are formatted into;
+ * it is reused after `clear`, so formatting does not allocate
+ * once the buffer has grown
+ */
+class document_sink
+{
+public:
+    document_sink& operator<<(
+                              const std::string& text);
+    document_sink& operator<<(
+                              const char* text);
+    document_sink& operator<<(
+                              char ch);
+    document_sink& operator<<(
+                              int value);
+    /**
+     * appends `value` as std::ostream with default flags does,
+     * ie. printf("%g")
+     */
+    document_sink& operator<<(
+                              double value);
+
+    /**
+     * appends `size` bytes of `data` as they are
+     */
+    void append(
+                const char* data,
+                size_t size);
+
+    /**
+     * appends `value` with `precision` decimal places, ie. printf("%.*f")
+     */
+    void put_fixed(
+                   double value,
+                   int precision);
+
+    /**
+     * pads text appended since position `from` with spaces
+     * to `width` characters, as std::left << std::setw(width)
+     */
+    void pad(
+             size_t from,
+             size_t width);
+
+public:
+    inline size_t size() const
+    {
+        return buffer.size();
+    }
+    inline const char* data() const
+    {
+        return buffer.data();
+    }
+    inline void clear()
+    {
+        buffer.clear();
+    }
+
+public:
+    // enough for any double formatted with precision up to 15
+    static const size_t number_buffer_size = 512;
+
+    /**
+     * formats `value` as printf("%g") into `out`, returns its length;
+     * `out` has to have at least `number_buffer_size` chars
+     */
+    static size_t format_general(
+                                 char* out,
+                                 double value);
+    /**
+     * formats `value` as printf("%.*f") into `out`, returns its length;
+     * `out` has to have at least `number_buffer_size` chars
+     */
+    static size_t format_fixed(
+                               char* out,
+                               double value,
+                               int precision);
+
+private:
+    std::string buffer;
+};
+
+#endif /* !DOCUMENT_SINK_HPP */
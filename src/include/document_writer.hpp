@@ -22,8 +22,10 @@
 #ifndef DOCUMENT_WRITER_HPP
 #define DOCUMENT_WRITER_HPP
 
+#include <chrono>
 #include <fstream>
 #include "rna_tree.hpp"
+#include "document_sink.hpp"
 
 // US letter
 #define LETTER              point({2*612, 2*792})
@@ -32,6 +34,7 @@
 
 struct RGB;
 class document_writer;
+struct gzFile_s;
 
 typedef std::vector<std::unique_ptr<document_writer>> image_writers;
 
@@ -50,6 +53,55 @@ struct label_info
     int tmp_ix; //position of the nucleotide in the template
 };
 
+/**
+ * Numbering label placed next to residue `ix`.
+ */
+struct numbering_label
+{
+    int ix;
+    point p; // label position
+    point line_from; // line connecting residue with the label
+    point line_to;
+};
+
+typedef std::vector<numbering_label> numbering_labels;
+
+/**
+ * Writer independent description of drawn RNA, built once from the tree
+ * and serialized by every writer.
+ */
+struct render_model
+{
+    enum element_type
+    {
+        label,      // residue `label` with `status`, `info` and `pair`
+        terminal,   // 5' or 3' end `label`, drawn as residue
+        base_pair,  // line `from`-`to` between paired residues
+        backbone,   // line `from`-`to` between consecutive residues
+        numbering,  // numbering `label` with line `from`-`to`
+        circle,     // circle with centre `from` and `radius`
+    };
+    
+    struct element
+    {
+        element_type type;
+        rna_label label;
+        rna_pair_label::status_type status;
+        label_info info;
+        // index of paired residue (counting `label` elements), -1 if unpaired
+        int pair = -1;
+        point from;
+        point to;
+        double radius;
+    };
+    
+    void add_circle(
+                    point centre,
+                    double radius);
+    
+    std::vector<element> elements;
+};
+
 /**
  * class for printing visualization
  */
@@ -64,19 +116,35 @@ protected:
     
 public:
     /**
-     * initialize, and return all known writers
+     * closes document if it was not closed explicitly, errors are not reported
+     */
+    virtual ~document_writer();
+    
+public:
+    /**
+     * initialize, and return all known writers; layout has no colors,
+     * so it is written only with `use_colors` unset, as json and also
+     * as binary when `binary_layout` is set
      */
     static image_writers get_writers(
-                                     bool use_colors);
+                                     bool use_colors,
+                                     bool use_compression = false,
+                                     bool binary_layout = false);
     static std::unique_ptr<document_writer> get_traveler_writer();
     
 public:
     
     /**
-     * print `text` to document
+     * append `text` to document, returns position where it starts
      */
-    virtual streampos print(
-                            const std::string& text) = 0;
+    streampos print(
+                    const std::string& text);
+    
+    /**
+     * append `model` formatted by this writer to document
+     */
+    virtual void print(
+                       const render_model& model);
     
     /**
      * set, if writer should use colors in output
@@ -84,120 +152,159 @@ public:
     void use_colors(
                     bool colored);
     
-public: // formatters
-    virtual std::string get_circle_formatted(
-                                             point centre,
-                                             double radius) const = 0;
-    std::string get_edge_formatted(
-                                   point from,
-                                   point to,
-                                   bool is_base_pair = true) const;
-    std::string get_numbering_formatted(
-            rna_tree::pre_post_order_iterator it,
-            const int ix,
-            const float residue_distance,
-            const std::vector<point> pos_residues,
-            const std::vector<std::pair<point, point>> lines,
-            const numbering_def& numbering) const;
-
-    std::string get_label_formatted(
-                                    rna_tree::pre_post_order_iterator it,
-                                    const label_info li) const;
-    virtual std::string get_label_formatted(
-                                            const rna_label& label,
-                                            const RGB& color,
-                                            const label_info li) const = 0;
-
-    virtual std::string get_label_formatted(
-            const rna_label& label,
-            const std::string& clazz,
-            const label_info li) const = 0;
+    /**
+     * set, if document should be gzip compressed while it is written;
+     * has to be set before `init`
+     */
+    void use_compression(
+                         bool compressed);
     
-public:
     /**
-     * returns rna backbone visualization
+     * set, if document should be appended to `document` instead of file,
+     * nullptr restores writing to files; has to be set before `init`,
+     * document in memory is never compressed
      */
-    std::string get_rna_background_formatted(
-                                             rna_tree::pre_post_order_iterator begin,
-                                             rna_tree::pre_post_order_iterator end) const;
-    std::string get_rna_formatted(
-                                  rna_tree rna,
-                                  const numbering_def& numbering) const;
-    std::string get_rna_subtree_formatted(
-                                          rna_tree &rna,
-                                          const numbering_def& numbering) const;
+    void use_memory(
+                    std::string* document);
     
 public:
     /**
-     * initialize new document_writer on document `filename`.`suffix`
+     * statistics of last written document, complete after `close`
      */
-    void init(
-              const std::string& filename,
-              const std::string& suffix);
+    struct write_stats
+    {
+        std::string file;
+        // bytes of formatted document
+        size_t bytes = 0;
+        // bytes of document stored on disk or in memory, after compression
+        size_t stored = 0;
+        // seconds from `init` to `close`
+        double seconds = 0;
+        
+        double get_ratio() const;
+        double get_throughput() const;
+    };
+    
+    inline const write_stats& get_write_stats() const
+    {
+        return stats;
+    }
+    
+public: // formatters, append formatted element to `out`
+    virtual void format_circle(
+                               document_sink& out,
+                               point centre,
+                               double radius) const = 0;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const RGB& color,
+                              const label_info& li) const = 0;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const std::string& clazz,
+                              const label_info& li) const = 0;
+    
+public:
     /**
-     * initialize writer, set basic properties to document (scale/..)
+     * place numbering labels so they do not overlap residues and base pairs,
+     * placement does not depend on writer, so it can be shared by all of them
      */
-    virtual void init(
-                      const std::string& filename,
-                      rna_tree& rna) = 0;
+    static numbering_labels get_numbering_labels(
+                                                 rna_tree& rna,
+                                                 const numbering_def& numbering);
     
     /**
-     * fill document from actual position to end of file with `ch`-chars
-     * and seek to actual position
+     * collect everything drawn for `rna` with `numbering` into render model
      */
-    size_t fill(
-                char ch = ' ');
+    static render_model get_render_model(
+                                         rna_tree& rna,
+                                         const numbering_labels& numbering);
     
 public:
     /**
-     * seek to `pos`
+     * initialize new document_writer on document `filename`.`suffix`,
+     * `footer` is appended once when document is closed
      */
-    void seek(
-              streampos pos);
-    
+    void init(
+              const std::string& filename,
+              const std::string& suffix,
+              const std::string& footer = "");
     /**
-     * seeks to the end of file
+     * initialize writer, set basic properties to document (scale/..)
      */
-    void seek_end();
+    virtual void init(
+                      const std::string& filename,
+                      rna_tree& rna) = 0;
     
     /**
-     * return actual position in stream
+     * append footer, flush and close document
      */
-    streampos get_pos();
-
+    void close();
+    
+public:
     virtual void set_scaling_ratio(rna_tree& rna);
     
 protected:
-    virtual std::string get_line_formatted(
-                                           point from,
-                                           point to,
-                                           const RGB& color) const = 0;
-    virtual std::string get_line_formatted(
-            point from,
-            point to,
-            const std::string& clazz) const = 0;
-    /**
-     * flush `text` to output
-     */
-    void print_to_stream(
-                         const std::string& text);
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const RGB& color) const = 0;
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const std::string& clazz) const = 0;
     const RGB& get_default_color(
                                  rna_pair_label::status_type status) const;
+
+    virtual double get_scaling_ratio() const;
     
     /**
-     * seek with offset
+     * sink document is formatted into, it is written out when it is full
+     * or when document is closed
      */
-    void seek_from_current_pos(
-                               off_type offset);
-
-    virtual double get_scaling_ratio() const;
+    inline document_sink& get_sink()
+    {
+        return sink;
+    }
 
 private:
+    /**
+     * write content of `sink` to document, when `force` or sink is full
+     */
+    void flush_sink(
+                    bool force);
+    /**
+     * write `size` bytes of `data` to opened document
+     */
+    void write_out(
+                   const char* data,
+                   size_t size);
     void validate_stream() const;
+    /**
+     * returns suffix of document with `suffix` when it is compressed
+     */
+    static std::string get_compressed_suffix(
+                                             const std::string& suffix);
     
 private:
+    // documents are written only by appending, everything goes
+    // through `sink` which is written out when it is full
+    document_sink sink;
     std::ofstream out;
+    // used instead of `out` when document is compressed
+    gzFile_s* compressed_out = nullptr;
+    // used instead of files when document is kept in memory
+    std::string* memory_out = nullptr;
+    bool memory_opened = false;
+    std::string footer;
+    write_stats stats;
+    std::chrono::steady_clock::time_point opened;
     bool colored = false;
+    bool compressed = false;
 
     double scaling_ratio = 1;
 };
@@ -0,0 +1,85 @@
+/*
+ * File: job_context.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef JOB_CONTEXT_HPP
+#define JOB_CONTEXT_HPP
+
+#include <string>
+
+/**
+ * state of one layout job, eg. batch job or server request; while it is
+ * entered by `job_context::scope` in a thread, trees and nodes created
+ * by that thread are numbered by it and log messages are tagged by its name,
+ * so concurrent jobs do not share counters and their ids are the same
+ * as if they ran alone. Without context process-wide atomic counters are used.
+ */
+class job_context
+{
+public:
+    /**
+     * enters context for calling thread until it is destroyed
+     */
+    class scope
+    {
+    public:
+        scope(
+              job_context& context);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        job_context* previous;
+    };
+
+public:
+    job_context(
+                const std::string& name = "");
+
+    job_context(const job_context&) = delete;
+    job_context& operator=(const job_context&) = delete;
+
+    inline const std::string& name() const
+    {
+        return _name;
+    }
+
+public:
+    /**
+     * context entered by calling thread or nullptr
+     */
+    static job_context* current();
+
+    /**
+     * next id of tree or node, from current context if there is one
+     */
+    static size_t next_tree_id();
+    static size_t next_node_id();
+
+private:
+    std::string _name;
+    size_t tree_ids = 0;
+    size_t node_ids = 0;
+};
+
+#endif /* !JOB_CONTEXT_HPP */
@@ -0,0 +1,51 @@
+/*
+ * File: layout_extractor.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef LAYOUT_EXTRACTOR_HPP
+#define LAYOUT_EXTRACTOR_HPP
+
+#include "extractor.hpp"
+
+/**
+ * reads residues from layout written by layout_writer,
+ * both json and binary format are recognized
+ */
+class layout_extractor : public extractor
+{
+protected:
+    virtual void extract(
+                         const std::string& filename);
+    virtual std::string get_type() const
+    {
+        return "layout";
+    }
+
+private:
+    void extract_json(
+                      const char* begin,
+                      const char* end);
+    void extract_binary(
+                        const char* begin,
+                        const char* end);
+};
+
+#endif /* !LAYOUT_EXTRACTOR_HPP */
@@ -0,0 +1,117 @@
+/*
+ * File: layout_writer.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef LAYOUT_WRITER_HPP
+#define LAYOUT_WRITER_HPP
+
+#include "document_writer.hpp"
+
+// binary layout starts with magic and version, both followed by 4-byte integers
+#define LAYOUT_BINARY_MAGIC         "TRLAYOUT"
+#define LAYOUT_BINARY_MAGIC_SIZE    8
+#define LAYOUT_BINARY_VERSION       1
+
+/**
+ * writes layout of residues as columns: x, y, base, index of paired
+ * residue (-1 if unpaired) and position in template as shown in svg
+ * titles (0 if residue is not in template); 5' and 3' ends, lines
+ * and numbering are left out.
+ *
+ * json:
+ *  {"name":"..","residues":N,"x":[..],"y":[..],"base":"..","pair":[..],"template":[..]}
+ * binary, little-endian:
+ *  magic, uint32 version, uint32 N, uint32 name length, name,
+ *  float64 x[N], float64 y[N], char base[N], int32 pair[N], int32 template[N]
+ *
+ * coordinates are the ones used internally, y axis points up
+ */
+class layout_writer : public document_writer
+{
+public:
+    enum format_type
+    {
+        json,
+        binary,
+    };
+
+public:
+    layout_writer(
+                  format_type format = json);
+    virtual ~layout_writer() = default;
+
+public:
+    virtual void init(
+                      const std::string& filename,
+                      rna_tree& rna);
+
+    using document_writer::print;
+    /**
+     * columns have to be complete before they are written,
+     * so whole `model` is formatted at once
+     */
+    virtual void print(
+                       const render_model& model);
+
+public: // formatters, layout does not draw anything
+    virtual void format_circle(
+                               document_sink& out,
+                               point centre,
+                               double radius) const;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const RGB& color,
+                              const label_info& li) const;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const std::string& clazz,
+                              const label_info& li) const;
+
+protected:
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const RGB& color) const;
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const std::string& clazz) const;
+
+private:
+    struct columns;
+
+    void format_json(
+                     document_sink& out,
+                     const columns& c) const;
+    void format_binary(
+                       document_sink& out,
+                       const columns& c) const;
+
+private:
+    format_type format;
+    std::string name;
+};
+
+#endif /* !LAYOUT_WRITER_HPP */
@@ -22,10 +22,21 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <atomic>
 #include <cstdarg>
+#include <memory>
 #include <vector>
 #include <sstream>
 
+// messages with lower priority are compiled out, eg. -DLOGGER_MIN_PRIORITY=2
+// leaves only INFO and higher priorities in the binary
+#ifndef LOGGER_MIN_PRIORITY
+#define LOGGER_MIN_PRIORITY     0
+#endif
+
+// messages waiting for writer thread, logging blocks when it is full
+#define LOGGER_QUEUE_SIZE       1024
+
 class logger
 {
 #define LOGGER_PRIORITY_FUNCTION(_fname, _priority) \
@@ -111,13 +122,19 @@ public:
            const std::vector<FILE*>& streams);
     ~logger();
     
+public:
+    /**
+     * waits until all logged messages are written and flushed
+     */
+    void flush();
+    
 public:
     /**
      * returns priority for this logger
      */
     inline priority get_priority() const
     {
-        return p;
+        return p.load(std::memory_order_relaxed);
     }
     
     /**
@@ -126,7 +143,7 @@ public:
     inline void set_priority(
                              priority other)
     {
-        p = other;
+        p.store(other, std::memory_order_relaxed);
     }
     
 protected:
@@ -137,11 +154,12 @@ protected:
                                       priority p);
     
     /**
-     * print `text` with priority `p`
+     * queue `text` with priority `p` for writer thread; messages
+     * with priority ERROR and higher are written before it returns
      */
     void log(
              priority p,
-             const std::string& text);
+             std::string text);
     
     /**
      * create new stream for this logger with pirority `p`
@@ -164,7 +182,7 @@ protected:
     inline bool can_log(
                         priority other) const
     {
-        return other >= p;
+        return other >= p.load(std::memory_order_relaxed);
     }
     
 public:
@@ -182,8 +200,15 @@ public:
     std::vector<int> opened_files() const;
     
 protected:
-    priority p;
+    /**
+     * ring buffer of messages written by background thread
+     */
+    struct async_writer;
+    
+    // jobs in other threads check it while it is changed
+    std::atomic<priority> p;
     std::vector<FILE*> out;
+    std::unique_ptr<async_writer> writer;
     
 #undef LOGGER_PRIORITY_FUNCTION_BODY
 #undef LOGGER_PRIORITY_FUNCTION
@@ -214,20 +239,26 @@ logger::logger_stream& logger::logger_stream::operator<<(
 
 
 // Define standard macros for using logger
+// arguments are evaluated and message is formatted only when it is logged,
+// macros are single statements, so they can be followed by `else`
 #ifndef NO_LOGGING
+#define LOGGER_ENABLED(_fname, _priority) \
+(logger::_priority >= LOGGER_MIN_PRIORITY && ::logger.is_ ## _fname ## _enabled())
 #define TRACE(...) \
-if (logger.is_trace_enabled()) \
-::logger.trace(__VA_ARGS__)
+do { if (LOGGER_ENABLED(trace, TRACE)) \
+::logger.trace(__VA_ARGS__); } while (false)
 #define DEBUG(...) \
-if (logger.is_debug_enabled()) \
-::logger.debug(__VA_ARGS__)
+do { if (LOGGER_ENABLED(debug, DEBUG)) \
+::logger.debug(__VA_ARGS__); } while (false)
 #define INFO(...) \
-if (logger.is_info_enabled()) \
-::logger.info(__VA_ARGS__)
+do { if (LOGGER_ENABLED(info, INFO)) \
+::logger.info(__VA_ARGS__); } while (false)
 #define WARN(...) \
-::logger.warn(__VA_ARGS__)
+do { if (LOGGER_ENABLED(warn, WARN)) \
+::logger.warn(__VA_ARGS__); } while (false)
 #define ERR(...) \
-::logger.error(__VA_ARGS__)
+do { if (LOGGER_ENABLED(error, ERROR)) \
+::logger.error(__VA_ARGS__); } while (false)
 
 #else
 // no logging
@@ -236,6 +267,7 @@ if (logger.is_info_enabled()) \
 #define INFO(...)
 #define WARN(...)
 #define ERR(...)
+#define LOGGER_ENABLED(_fname, _priority) false
 #endif
 
 #endif /* !LOGGER_HPP */
@@ -76,16 +76,17 @@ private:
      */
     edges get_edges(
                     rna_tree& rna);
-
+    
+#ifdef TESTS
+public:
+#endif
     /**
-     * run checks for edges
+     * run checks for edges,
+     * only edges close to each other (sharing grid cell) are compared
      */
     overlaps run(
                  const edges& e);
     
-#ifdef TESTS
-public:
-#endif
     /**
      * find point in which edges are intersecting each other
      * if no point exist, return point::bad_point
@@ -93,8 +94,6 @@ public:
     static point intersection(
                               const edge& e1,
                               const edge& e2);
-
-    static bool intersect(const edge& e1, const edge& e2);
     
 };
 
@@ -93,6 +93,18 @@ bool lies_on_line(const point& p1, const point& p2, const point& p3);
 
 bool lies_between(point p, point from, point to);
 
+/**
+ * z-coordinate of the cross product p1 x p2
+ */
+double cross(const point& p1, const point& p2);
+
+/**
+ * orientation of triplet (p1, p2, p3) without trigonometry;
+ * returns 1 if counter-clockwise, -1 if clockwise, 0 if collinear
+ * (up to rounding error of the determinant)
+ */
+int ccw(const point& p1, const point& p2, const point& p3);
+
 point abs(const point& p);
 
 
@@ -0,0 +1,183 @@
+/*
+ * File: profiler.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * collects wall time, CPU time, allocations and peak memory of stages
+ * of the run, stages are marked by PROFILE_STAGE; it is disabled
+ * until `enable` is called, then stages of all threads are recorded.
+ * Stages with the same name (eg. of several targets) are summed.
+ * Hardware counters of stages are optional, see `enable_counters`.
+ */
+class profiler
+{
+public:
+    /**
+     * hardware events counted by perf_event_open
+     */
+    enum counter
+    {
+        cycles,
+        instructions,
+        llc_misses,
+        branch_misses,
+        counters_count
+    };
+    typedef uint64_t counter_values[counters_count];
+
+    /**
+     * raw events of thread with nanoseconds its events were enabled
+     * and really counted; they differ when events share hardware counters
+     */
+    struct counter_sample
+    {
+        counter_values values = {};
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+
+    struct stage
+    {
+        std::string name;
+        size_t calls = 0;
+        // seconds
+        double wall = 0;
+        // seconds of CPU time of thread running stage
+        double cpu = 0;
+        // allocations by operator new made by thread running stage,
+        // zero unless program counts them, see count_allocation
+        size_t allocations = 0;
+        size_t allocated_bytes = 0;
+        // peak resident memory of process when stage ended, kB
+        long peak_rss = 0;
+        // events of thread running stage, only counted ones are non-zero
+        counter_values counters = {};
+    };
+
+public:
+    /**
+     * starts recording, time of report is measured from now
+     */
+    static void enable();
+    static void disable();
+    static bool is_enabled();
+    /**
+     * starts counting hardware events of stages in all threads;
+     * returns false if no event can be counted, eg. perf events are not
+     * supported or permitted by /proc/sys/kernel/perf_event_paranoid,
+     * then stages are only timed and report contains the reason
+     */
+    static bool enable_counters();
+    static bool is_counting();
+    /**
+     * returns if event `c` is counted
+     */
+    static bool is_counted(
+                           counter c);
+    static const char* get_counter_name(
+                                        counter c);
+    /**
+     * drops recorded stages
+     */
+    static void clear();
+
+    static void add(
+                    const stage& s);
+    /**
+     * recorded stages in order they were entered first
+     */
+    static std::vector<stage> get_stages();
+
+    /**
+     * report of whole run and all stages
+     */
+    static std::string to_json();
+    static void save(
+                     const std::string& filename);
+
+public:
+    /**
+     * records allocation of `size` bytes by calling thread; library
+     * does not replace operator new, programs which want allocations
+     * in the report call it from their own (traveler links
+     * src/app/allocation_counter.cpp)
+     */
+    static void count_allocation(
+                                 size_t size);
+    /**
+     * counters of calling thread
+     */
+    static size_t get_allocations();
+    static size_t get_allocated_bytes();
+    static double get_thread_cpu_time();
+    /**
+     * events counted in calling thread so far, not scaled
+     */
+    static void get_thread_counters(
+                                    counter_sample& sample);
+    /**
+     * events between samples `from` and `to` of one thread, extrapolated
+     * to whole interval if events were counted only part of it
+     */
+    static void get_counters_delta(
+                                   const counter_sample& from,
+                                   const counter_sample& to,
+                                   counter_values& delta);
+    /**
+     * peak resident memory of process, kB
+     */
+    static long get_peak_rss();
+};
+
+/**
+ * records stage `name` from its construction to its destruction
+ */
+class profile_scope
+{
+public:
+    profile_scope(
+                  const char* name);
+    ~profile_scope();
+
+    profile_scope(const profile_scope&) = delete;
+    profile_scope& operator=(const profile_scope&) = delete;
+
+private:
+    bool active;
+    profiler::stage value;
+    std::chrono::steady_clock::time_point wall;
+    double cpu = 0;
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+    profiler::counter_sample counters;
+};
+
+#define PROFILE_STAGE(name) \
+    profile_scope __profile_scope(name)
+
+#endif /* !PROFILER_HPP */
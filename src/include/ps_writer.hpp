@@ -31,48 +31,55 @@ class ps_writer : public document_writer
 public:
     virtual ~ps_writer() = default;
 public:
-    virtual streampos print(
-                            const std::string& text);
     virtual void init(
                       const std::string& filename,
                       rna_tree& rna);
     
-public:
-    virtual std::string get_circle_formatted(
-                                             point centre,
-                                             double radius) const;
-    virtual std::string get_label_formatted(
-                                            const rna_label& label,
-                                            const RGB& color,
-                                            const label_info li) const;
-    virtual std::string get_label_formatted(
-            const rna_label& label,
-            const std::string& clazz,
-            const label_info li) const;
+public: // formatters
+    virtual void format_circle(
+                               document_sink& out,
+                               point centre,
+                               double radius) const;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const RGB& color,
+                              const label_info& li) const;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const std::string& clazz,
+                              const label_info& li) const;
     
 protected:
-    virtual std::string get_line_formatted(
-                                           point from,
-                                           point to,
-                                           const RGB& color) const;
-    virtual std::string get_line_formatted(
-            point from,
-            point to,
-            const std::string& clazz) const;
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const RGB& color) const;
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const std::string& clazz) const;
     
 private:
-    std::string get_text_formatted(
-                                   point p,
-                                   const std::string& text) const;
+    void format_text(
+                     document_sink& out,
+                     point p,
+                     const std::string& text) const;
     
 private:
-    std::string get_color_formatted(
-                                    const RGB& color) const;
+    void format_color(
+                      document_sink& out,
+                      const RGB& color) const;
     std::string get_default_prologue() const;
     std::string get_default_prologue(
                                      rna_tree::pre_post_order_iterator root) const;
     
 private:
+    // color set by last `lw` command of current document, writer
+    // formats one document at a time, so it is not shared by jobs
     mutable const RGB* last_used = &RGB::BLACK;
 };
 
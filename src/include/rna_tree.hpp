@@ -48,6 +48,17 @@ public:
     void update_points(
                        const std::vector<point>& points);
     
+    /**
+     * update postorder points and set distances computed by `update_points`
+     * before, so that they are not computed again; 5' and 3' labels
+     * are left to caller
+     */
+    void restore_points(
+                        const std::vector<point>& points,
+                        double pairs_distance,
+                        double pair_base_distance,
+                        double loops_bases_distance);
+    
     /**
      * insert `label` to tree before `it` and set
      * `steal` next siblings to be children of inserted node
@@ -137,6 +148,11 @@ public:
     }
 
     void update_bounding_boxes(bool leafs_have_size = false);
+    /**
+     * updates bounding boxes of subtree of `root` and of its ancestors,
+     * other nodes have to be up to date
+     */
+    void update_bounding_boxes(iterator root, bool leafs_have_size = false);
 
     rna_pair_label get_node_by_id(const int id);
 
@@ -132,7 +132,7 @@ public:
         bounding_objects.insert(bounding_objects.end(), bos.begin(), bos.end());
     }
 
-    std::vector<rectangle> get_bounding_objects(){
+    const std::vector<rectangle>& get_bounding_objects() const {
         return bounding_objects;
     }
     
@@ -0,0 +1,150 @@
+/*
+ * File: server.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rna_tree.hpp"
+#include "compact.hpp"
+
+/**
+ * layout service listening on unix domain socket; templates are loaded
+ * once at start and every request lays out one target against one of them.
+ *
+ * request, one per connection:
+ *  header lines "KEY VALUE", empty line, target structure (FASTA-like,
+ *  BPSEQ, CT or Stockholm, first structure is used) up to end of input;
+ *  keys are:
+ *      template    id of template (required)
+ *      format      svg (default), ps, xml or json (layout)
+ *      colored     1 for colored document, default 0
+ *      overlaps    1 for highlighted overlaps, default 0
+ *      rotate      1 for rotating branches, default 0
+ *      timeout     seconds, lowers server timeout for this request;
+ *                  layout running out of time finishes in background,
+ *                  while `threads` of them run, timed requests are refused
+ * response:
+ *  "OK N", N bytes of document and line "STATS {json}" with times
+ *  of stages, overlaps, moved branches and time of layout rounds
+ *  and counts of processed and reused nodes,
+ *  or "ERROR message" line
+ */
+class server
+{
+public:
+    struct options
+    {
+        std::string socket;
+        // template id -> template bundle file
+        std::map<std::string, std::string> templates;
+        // number of requests served at once, 0 for number of cores
+        size_t threads = 0;
+        // seconds for one request, 0 for no limit
+        double timeout = 0;
+        layout_budget layout;
+        // default numbering is used when it is empty
+        numbering_def numbering;
+    };
+    
+    struct request
+    {
+        std::string templated;
+        std::string format = "svg";
+        bool colored = false;
+        bool overlaps = false;
+        bool rotate = false;
+        double timeout = 0;
+        std::string target;
+    };
+    
+    /**
+     * times of request stages in seconds
+     */
+    struct request_stats
+    {
+        size_t residues = 0;
+        size_t bytes = 0;
+        double parse = 0;
+        double ted = 0;
+        double layout = 0;
+        double render = 0;
+        double total = 0;
+        // beautification rounds of layout
+        compact::stats_vec rounds;
+        compact::reuse_stats reuse;
+        
+        std::string to_json() const;
+    };
+    
+public:
+    /**
+     * loads all templates, throws if some of them can not be loaded
+     */
+    server(
+           const options& opts);
+    
+    /**
+     * listen on socket and serve requests until process is terminated
+     */
+    void run();
+    
+    /**
+     * parse request `text`, throws wrong_argument_exception if it is malformed
+     */
+    static request parse_request(
+                                 const std::string& text);
+    
+    /**
+     * lay out request target and return document in requested format
+     */
+    std::string process(
+                        const request& r,
+                        request_stats& stats) const;
+    
+private:
+    /**
+     * accept and handle connections on `listening` socket one by one
+     */
+    void serve(
+               int listening);
+    
+#ifdef TEST
+public:
+#endif
+    /**
+     * read request from `connection`, process it and write response
+     */
+    void handle(
+                int connection);
+    
+    options opts;
+    std::map<std::string, rna_tree> templates;
+    // timed out layouts still running in background
+    std::atomic<size_t> abandoned{0};
+};
+
+#endif /* !SERVER_HPP */
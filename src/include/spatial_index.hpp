@@ -0,0 +1,194 @@
+/*
+ * File: spatial_index.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include <vector>
+#include "rectangle.hpp"
+
+/**
+ * uniform grid over points and line segments,
+ * answers which of them can touch a rectangle
+ */
+class spatial_index
+{
+public:
+    typedef std::pair<point, point>     line;
+
+public:
+    spatial_index() = default;
+
+    /**
+     * build index, `cell` is preferred grid cell size
+     */
+    spatial_index(
+                  const std::vector<point>& points,
+                  const std::vector<line>& lines,
+                  double cell);
+
+public:
+    /**
+     * returns if any indexed point lies in `r`
+     * and satisfies `filter`
+     */
+    template <typename funct>
+    bool any_point(
+                   const rectangle& r,
+                   funct filter) const;
+
+    /**
+     * returns if any indexed line intersects borders of `r`
+     * and satisfies `filter`
+     */
+    template <typename funct>
+    bool any_line(
+                  const rectangle& r,
+                  funct filter) const;
+
+    inline bool any_point(
+                          const rectangle& r) const
+    {
+        return any_point(r, [](const point&) { return true; });
+    }
+
+    inline bool any_line(
+                         const rectangle& r) const
+    {
+        return any_line(r, [](const line&) { return true; });
+    }
+
+private:
+    struct grid
+    {
+        // items[first[c] .. first[c + 1]) are registered in cell c
+        std::vector<size_t> first;
+        std::vector<size_t> items;
+    };
+
+    /**
+     * register boxes into `g`, box `i` into every cell it covers
+     */
+    void fill(
+              grid& g,
+              const std::vector<rectangle>& boxes) const;
+
+    /**
+     * call `f(index)` for every item of `g` registered in cells covered by `r`
+     * extended by `border` cells, stop when `f` returns true
+     */
+    template <typename funct>
+    bool find(
+              const grid& g,
+              const rectangle& r,
+              size_t border,
+              funct f) const;
+
+    size_t column(
+                  double x) const;
+    size_t row(
+               double y) const;
+
+private:
+    std::vector<point> points;
+    std::vector<line> lines;
+    // lines with bad points, always tested
+    std::vector<line> unbounded;
+
+    grid points_grid;
+    grid lines_grid;
+
+    point origin;
+    double cell = 1;
+    size_t columns = 0;
+    size_t rows = 0;
+};
+
+
+template <typename funct>
+bool spatial_index::find(
+                         const grid& g,
+                         const rectangle& r,
+                         size_t border,
+                         funct f) const
+{
+    if (columns == 0 || !r.initiated())
+        return false;
+
+    size_t x1 = column(r.top_left.x);
+    size_t x2 = column(r.bottom_right.x);
+    size_t y1 = row(r.bottom_right.y);
+    size_t y2 = row(r.top_left.y);
+
+    x1 = x1 > border ? x1 - border : 0;
+    y1 = y1 > border ? y1 - border : 0;
+    x2 = std::min(columns - 1, x2 + border);
+    y2 = std::min(rows - 1, y2 + border);
+
+    for (size_t y = y1; y <= y2; ++y)
+        for (size_t x = x1; x <= x2; ++x)
+        {
+            size_t c = y * columns + x;
+            for (size_t k = g.first[c]; k < g.first[c + 1]; ++k)
+                if (f(g.items[k]))
+                    return true;
+        }
+
+    return false;
+}
+
+template <typename funct>
+bool spatial_index::any_point(
+                              const rectangle& r,
+                              funct filter) const
+{
+    return find(points_grid, r, 0,
+                [&](size_t i)
+                {
+                    return r.has(points[i]) && filter(points[i]);
+                });
+}
+
+template <typename funct>
+bool spatial_index::any_line(
+                             const rectangle& r,
+                             funct filter) const
+{
+    // rectangle::intersects tolerates near misses,
+    // so also neighbouring cells are searched
+    auto test =
+    [&](const line& l)
+    {
+        return r.intersects(l.first, l.second) && filter(l);
+    };
+
+    for (const line& l : unbounded)
+        if (test(l))
+            return true;
+
+    return find(lines_grid, r, 1,
+                [&](size_t i)
+                {
+                    return test(lines[i]);
+                });
+}
+
+#endif /* !SPATIAL_INDEX_HPP */
@@ -0,0 +1,169 @@
+/*
+ * File: structure_reader.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef STRUCTURE_READER_HPP
+#define STRUCTURE_READER_HPP
+
+#include "utils.hpp"
+
+struct gzFile_s;
+
+/**
+ * reads secondary structures from file one record at a time; supported
+ * formats are dot-bracket fasta, BPSEQ, CT and Stockholm (structure is
+ * taken from #=GR SS of sequence or from #=GC SS_cons, gap columns are
+ * removed). Base pairs are converted to dot-bracket, pairs crossing
+ * other pairs are written as pseudoknot brackets.
+ *
+ * File can be gzip compressed. It is read by blocks, so only the record
+ * being read (whole alignment for Stockholm) is kept in memory.
+ */
+class structure_reader
+{
+public:
+    enum format_type
+    {
+        detect,         // recognized from content of file
+        dot_bracket,
+        bpseq,
+        ct,
+        stockholm,
+    };
+
+public:
+    structure_reader(
+                     const std::string& filename,
+                     format_type format = detect);
+    ~structure_reader();
+
+    structure_reader(const structure_reader&) = delete;
+    structure_reader& operator=(const structure_reader&) = delete;
+
+    /**
+     * reads next structure into `record`, returns false at the end of file
+     */
+    bool next(
+              fasta& record);
+
+    inline format_type get_format() const
+    {
+        return format;
+    }
+
+public:
+    /**
+     * reads first structure of `text`, format is detected; `name` stands
+     * for file name in messages and default ids; throws
+     * wrong_argument_exception if there is no structure
+     */
+    static fasta read_text(
+                           const std::string& text,
+                           const std::string& name);
+
+    /**
+     * converts pair table (index of paired base or -1) to dot-bracket
+     */
+    static std::string get_brackets(
+                                    const std::vector<int>& pairs);
+
+    /**
+     * returns pair table of structure in WUSS notation used by Stockholm
+     */
+    static std::vector<int> get_wuss_pairs(
+                                           const std::string& structure);
+
+private:
+    /**
+     * reader of `text` kept in memory
+     */
+    structure_reader(
+                     const std::string& name,
+                     const std::string& text,
+                     format_type format);
+
+    struct line
+    {
+        const char* begin;
+        const char* end;
+
+        inline std::string str() const
+        {
+            return std::string(begin, end);
+        }
+    };
+
+    /**
+     * reads next line, it is valid until next line is read
+     */
+    bool next_line(
+                   line& l);
+    /**
+     * returns `l`, last line read, back to input
+     */
+    void unread(
+                const line& l);
+    /**
+     * reads next block of input to `buffer`, returns false at the end of file
+     */
+    bool fill();
+    /**
+     * splits `l` to whitespace separated words
+     */
+    void split(
+               const line& l,
+               std::vector<std::string>& words) const;
+
+    format_type detect_format();
+    std::string get_default_id() const;
+
+    bool next_dot_bracket(
+                          fasta& record);
+    bool next_bpseq(
+                    fasta& record);
+    bool next_ct(
+                 fasta& record);
+    bool next_stockholm(
+                        fasta& record);
+    /**
+     * reads one alignment, up to `//`, into `alignment`
+     */
+    bool read_alignment();
+
+private:
+    std::string filename;
+    // nullptr when whole input is in `buffer`
+    gzFile_s* in = nullptr;
+    // block of input, lines before `position` were read already
+    std::string buffer;
+    size_t position = 0;
+    // position of lines read ahead, which are kept in `buffer`
+    size_t mark = std::string::npos;
+    bool end_of_file = false;
+    format_type format;
+    size_t records = 0;
+
+    // sequences of actual Stockholm alignment, not returned yet
+    std::vector<fasta> alignment;
+    size_t aligned = 0;
+};
+
+#endif /* !STRUCTURE_READER_HPP */
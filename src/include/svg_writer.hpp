@@ -37,31 +37,34 @@ public:
     virtual void init(
                       const std::string& filename,
                       rna_tree& rna);
-    virtual streampos print(
-                            const std::string& text);
     
 public: // formatters
-    virtual std::string get_circle_formatted(
-                                             point centre,
-                                             double radius) const;
-    virtual std::string get_label_formatted(
-                                            const rna_label& label,
-                                            const RGB& color,
-                                            const label_info li) const;
-    virtual std::string get_label_formatted(
-            const rna_label& label,
-            const std::string& clazz,
-            const label_info li) const;
+    virtual void format_circle(
+                               document_sink& out,
+                               point centre,
+                               double radius) const;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const RGB& color,
+                              const label_info& li) const;
+    virtual void format_label(
+                              document_sink& out,
+                              const rna_label& label,
+                              const std::string& clazz,
+                              const label_info& li) const;
     
 protected:
-    virtual std::string get_line_formatted(
-                                           point from,
-                                           point to,
-                                           const RGB& color) const;
-    virtual std::string get_line_formatted(
-            point from,
-            point to,
-            const std::string& clazz) const;
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const RGB& color) const;
+    virtual void format_line(
+                             document_sink& out,
+                             point from,
+                             point to,
+                             const std::string& clazz) const;
 
 //    double get_scaling_ratio() const;
     
@@ -84,11 +87,18 @@ private:
 //            const int ix) const;
     std::string create_style_definitions() const;
     
-    properties get_point_formatted(
-                                   point p,
-                                   const std::string& prefix,
-                                   const std::string& postfix,
-                                   bool should_shift_p = true) const;
+    /**
+     * appends attributes `prefix`x`postfix` and `prefix`y`postfix`
+     * of `p` shifted to document coordinates
+     */
+    void format_point(
+                      document_sink& out,
+                      point p,
+                      const char* prefix,
+                      const char* postfix) const;
+    void format_title(
+                      document_sink& out,
+                      const label_info& li) const;
 
     void scale_point(point &p) const;
     
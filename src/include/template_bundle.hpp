@@ -0,0 +1,67 @@
+/*
+ * File: template_bundle.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef TEMPLATE_BUNDLE_HPP
+#define TEMPLATE_BUNDLE_HPP
+
+#include <string>
+
+#define TEMPLATE_BUNDLE_MAGIC       "TRBUNDLE"
+#define TEMPLATE_BUNDLE_MAGIC_SIZE  8
+#define TEMPLATE_BUNDLE_VERSION     1
+
+class rna_tree;
+
+/**
+ * template prepared for layout (structure, labels, points, distances
+ * and 5'/3' ends) stored in one binary file, so that it is loaded
+ * without extracting the image and computing distances again.
+ *
+ * little-endian, float64 columns are 8-byte aligned in the file:
+ *  magic, uint32 version, uint32 N,
+ *  float64 pairs_distance, pair_base_distance, loops_bases_distance,
+ *  uint32 ends (1 if 5'/3' ends are set), uint32 name length,
+ *  float64 5' x, 5' y, 3' x, 3' y,
+ *  float64 x[N], float64 y[N], char brackets[N], char labels[N], name
+ */
+class template_bundle
+{
+public:
+    /**
+     * writes template `rna` with points set by `update_points`
+     */
+    static void save(
+                     rna_tree& rna,
+                     const std::string& filename);
+    /**
+     * reads template written by `save`
+     */
+    static rna_tree load(
+                         const std::string& filename);
+    /**
+     * returns if `filename` starts with bundle magic
+     */
+    static bool is_bundle(
+                          const std::string& filename);
+};
+
+#endif /* !TEMPLATE_BUNDLE_HPP */
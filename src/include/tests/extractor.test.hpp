@@ -0,0 +1,75 @@
+/*
+ * File: extractor.test.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef EXTRACTOR_TEST_HPP
+#define EXTRACTOR_TEST_HPP
+
+#include <vector>
+#include "test.test.hpp"
+#include "point.hpp"
+
+class extractor_test : public test
+{
+public:
+    extractor_test();
+    virtual ~extractor_test() = default;
+    virtual void run();
+
+private:
+    void test_crw_lines();
+    void test_crw_templates();
+    void test_xml_scanner();
+    void test_xml_lines();
+    void test_xml_templates();
+    void test_layout();
+    void test_template_bundle();
+
+    /**
+     * reference extraction of crw bases with std::regex
+     */
+    static void extract_crw_regex(
+                const std::string& filename,
+                std::string& labels,
+                std::vector<point>& points);
+
+    /**
+     * reference extraction of varna and traveler bases with std::regex
+     */
+    static void extract_varna_regex(
+                const std::string& filename,
+                std::string& labels,
+                std::vector<point>& points);
+    static void extract_traveler_regex(
+                const std::string& filename,
+                std::string& labels,
+                std::vector<point>& points);
+
+    /**
+     * compares extractor `type` with `reference` on all files matching `pattern`
+     */
+    void compare_templates(
+                const std::string& pattern,
+                const std::string& type,
+                void (*reference)(const std::string&, std::string&, std::vector<point>&));
+};
+
+#endif /* !EXTRACTOR_TEST_HPP */
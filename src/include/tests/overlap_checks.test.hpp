@@ -38,6 +38,8 @@ private:
                 point p1,
                 point p2,
                 bool intersects);
+    void test_run(
+                size_t edges_count);
 };
 
 #endif /* !OVERLAP_CHECKS_TEST_HPP */
@@ -37,9 +37,19 @@ private:
     void test_exist_file();
     void test_io();
     void test_read_fasta_file();
+    void test_structure_reader();
+    void test_compressed_structures();
+    void test_brackets();
+    void test_profiler();
+    void test_logger();
 
     std::string create_fasta_text();
     fasta create_fasta();
+    /**
+     * writes `text` to file and reads all structures from it
+     */
+    std::vector<fasta> read_structures(
+                                       const std::string& text);
 };
 
 #endif /* !UTILS_TEST_HPP */
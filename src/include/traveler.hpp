@@ -0,0 +1,167 @@
+/*
+ * File: traveler.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef TRAVELER_HPP
+#define TRAVELER_HPP
+
+#include <string>
+
+#include "rna_tree.hpp"
+#include "compact.hpp"
+#include "mapping.hpp"
+#include "document_writer.hpp"
+#include "overlap_checks.hpp"
+
+struct fasta;
+
+/**
+ * library interface of traveler: every step of laying out target structure
+ * by template layout is one call, documents are rendered into memory.
+ * Errors are reported by exceptions derived from my_exception.
+ *
+ * typical use:
+ *  rna_tree templated = traveler::load_template_bundle(bundle);
+ *  rna_tree target = traveler::build_target(structure);
+ *  mapping m = traveler::compute_mapping(templated, target);
+ *  traveler::layout_stats stats = traveler::layout(templated, target, m, options);
+ *  render_model model = traveler::get_render_model(templated, numbering);
+ *  std::string svg = traveler::render(templated, model, traveler::svg, false);
+ *
+ * calls do not share any state, so different trees can be processed
+ * in parallel; one template loaded once can be copied for every target.
+ */
+class traveler
+{
+public:
+    enum format_type
+    {
+        svg,
+        ps,
+        xml,        // traveler intermediate format
+        json,       // layout
+        binary,     // layout
+    };
+    
+    struct layout_options
+    {
+        bool rotate_branches = false;
+        layout_budget budget;
+    };
+    
+    /**
+     * what layout did, one entry per beautification round
+     * (there are none without rotate_branches) and how many nodes
+     * kept coordinates of template
+     */
+    struct layout_stats
+    {
+        compact::stats_vec iterations;
+        compact::reuse_stats reuse;
+    };
+    
+public:
+    /**
+     * template from layout in `image_file` of `image_format`
+     * (crw, varna, traveler) and its structure in `structure_file`
+     */
+    static rna_tree load_template(
+                                  const std::string& image_file,
+                                  const std::string& image_format,
+                                  const std::string& structure_file);
+    /**
+     * template saved by `save_template_bundle`
+     */
+    static rna_tree load_template_bundle(
+                                         const std::string& bundle_file);
+    static void save_template_bundle(
+                                     rna_tree& templated,
+                                     const std::string& bundle_file);
+    
+    /**
+     * target tree of `structure`
+     */
+    static rna_tree build_target(
+                                 const fasta& structure);
+    /**
+     * target tree of first structure in `text`, in any format
+     * structure files can have
+     */
+    static rna_tree build_target(
+                                 const std::string& text);
+    
+    /**
+     * tree-edit-distance mapping of `templated` to `target`;
+     * it refers to node ids of both trees, so the same trees
+     * have to be laid out by it
+     */
+    static mapping compute_mapping(
+                                   rna_tree& templated,
+                                   rna_tree& target);
+    
+    /**
+     * edits `templated` by `m` to structure of `target` and computes
+     * positions of residues which are not in template
+     */
+    static layout_stats layout(
+                       rna_tree& templated,
+                       rna_tree& target,
+                       const mapping& m,
+                       const layout_options& options);
+    
+    /**
+     * overlapping parts of laid out `rna`
+     */
+    static overlap_checks::overlaps find_overlaps(
+                                                  rna_tree& rna);
+    
+    /**
+     * everything drawn for laid out `rna`, `overlaps` are highlighted;
+     * default numbering is used when `numbering` has no positions
+     */
+    static render_model get_render_model(
+                                         rna_tree& rna,
+                                         const numbering_def& numbering,
+                                         const overlap_checks::overlaps& overlaps = overlap_checks::overlaps());
+    
+    /**
+     * document of `rna` with its `model` in `format`
+     */
+    static std::string render(
+                              rna_tree& rna,
+                              const render_model& model,
+                              format_type format,
+                              bool colored);
+    
+    /**
+     * writer of documents in `format`
+     */
+    static std::unique_ptr<document_writer> get_writer(
+                                                       format_type format);
+    /**
+     * format of `name` (svg, ps, xml, json, binary),
+     * throws wrong_argument_exception for unknown name
+     */
+    static format_type get_format(
+                                  const std::string& name);
+};
+
+#endif /* !TRAVELER_HPP */
@@ -22,6 +22,8 @@
 #ifndef TREE_BASE_HPP
 #define TREE_BASE_HPP
 
+#include "job_context.hpp"
+
 #include "tree_hh/tree.hh"
 #undef assert
 #include "types.hpp"
@@ -153,11 +155,9 @@ public:
         return _tree.next_sibling(it);
     }
     
-private:
-    static size_t ID;
-    
 protected:
-    size_t _id = ID++;
+    // numbered by job creating the tree, see job_context
+    size_t _id = job_context::next_tree_id();
     tree_type _tree;
     size_t _size;
 };
@@ -24,6 +24,8 @@
 
 #include <cstddef>
 
+#include "job_context.hpp"
+
 class node_base
 {
 public:
@@ -34,13 +36,13 @@ protected:
 
 public:
     size_t id() const;
-    void reset_id();
-    static void reset_ID();
+    void set_id(
+                size_t id);
 
-private:
-    static size_t ID;
 protected:
-    size_t _id = ID++;
+    // nodes are created in more threads at once by batch jobs,
+    // they are numbered by their job, see job_context
+    size_t _id = job_context::next_node_id();
 
 };
 
@@ -30,11 +30,6 @@
 // tree<> functions:
 //
 
-/* static */
-template <typename label_type>
-size_t tree_base<label_type>::ID = 0;
-
-
 template <typename label_type>
 template <typename labels_array>
 tree_base<label_type>::tree_base(
@@ -168,11 +163,10 @@ void tree_base<label_type>::set_postorder_ids()
     APP_DEBUG_FNAME;
 
     post_order_iterator it;
-
-    label_type::reset_ID();
+    size_t i = 0;
 
     for (it = begin_post(); it != end_post(); ++it)
-        it->reset_id();
+        it->set_id(i++);
 
     assert(size() - 1 == ::id(begin()));
 }
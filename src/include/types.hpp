@@ -110,11 +110,12 @@ private:
 struct print_class_BEG_END_name
 {
     print_class_BEG_END_name(
-                             const std::string& _name);
+                             const char* _name);
     ~print_class_BEG_END_name();
     
 private:
-    std::string fname;
+    // not copied, function names are static strings
+    const char* fname;
 };
 
 
@@ -129,6 +130,7 @@ logger_end_of_function_priority __logger_priority(logger_end_of_function_priorit
 print_class_BEG_END_name __function_name(__PRETTY_FUNCTION__)
 
 #define LOGGER_PRINT_CONTAINER(container, name) \
+if (LOGGER_ENABLED(debug, DEBUG)) \
 { \
 auto stream = logger.debug_stream(); \
 stream << (name) << ":\n"; \
@@ -141,6 +143,11 @@ struct numbering_def {
     int interval{}; // number telling Traveler to number every residue position which is modulo interval == 0
 };
 
+struct layout_budget {
+    size_t max_iterations = 3; // beautification rounds, 0 for no limit (runs until overlaps stop decreasing)
+    double time = 0; // wall-clock limit of beautification in seconds (checked between rounds), 0 for no limit
+};
+
 #endif /* !TYPES_HPP */
 
 /* always include and redefine assert and abort macros */
@@ -90,4 +90,43 @@ void write_file(
 fasta read_fasta_file(
                       const std::string& filename);
 
+/**
+ * reads first structure from `filename` in any format known
+ * to structure_reader (dot-bracket fasta, BPSEQ, CT, Stockholm)
+ */
+fasta read_structure_file(
+                          const std::string& filename);
+
+/**
+ * read-only view of whole file mapped into memory
+ */
+class mapped_file
+{
+public:
+    mapped_file(
+                const std::string& filename);
+    ~mapped_file();
+    
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    
+public:
+    inline const char* begin() const
+    {
+        return data;
+    }
+    inline const char* end() const
+    {
+        return data + length;
+    }
+    inline size_t size() const
+    {
+        return length;
+    }
+    
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+};
+
 #endif /* !UTILS_HPP */
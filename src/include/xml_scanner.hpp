@@ -0,0 +1,122 @@
+/*
+ * File: xml_scanner.hpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef XML_SCANNER_HPP
+#define XML_SCANNER_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * streaming scanner of XML documents, returns start tags one by one
+ * with their attributes and text content following them;
+ * line breaks are insignificant, comments, declarations, processing
+ * instructions and end tags are skipped, entities are not decoded
+ */
+class xml_scanner
+{
+public:
+    /**
+     * part of scanned document, not owning
+     */
+    struct span
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        bool operator==(
+                        const char* str) const;
+        inline bool operator!=(
+                               const char* str) const
+        {
+            return !(*this == str);
+        }
+        inline size_t size() const
+        {
+            return end - begin;
+        }
+        inline std::string str() const
+        {
+            return std::string(begin, end);
+        }
+
+        /**
+         * parse whole span as number, returns false if it is not a number
+         */
+        bool to_double(
+                       double& value) const;
+    };
+
+    struct attribute
+    {
+        span name;
+        span value;
+    };
+
+    struct element
+    {
+        span name;
+        std::vector<attribute> attributes;
+        // text up to next tag with surrounding whitespace removed,
+        // empty for self-closing elements
+        span text;
+        bool self_closing = false;
+
+        /**
+         * returns value of attribute `name` or nullptr
+         */
+        const span* get(
+                        const char* name) const;
+    };
+
+public:
+    xml_scanner(
+                const char* begin,
+                const char* end);
+
+    /**
+     * reads next start tag into `e`, returns false at the end of document
+     */
+    bool next(
+              element& e);
+
+private:
+    /**
+     * skips markup starting at `p` which is not start tag,
+     * returns position after it
+     */
+    const char* skip_markup(
+                            const char* p) const;
+
+    /**
+     * reads start tag starting at `p` into `e`, returns position after it
+     * or nullptr if tag is malformed
+     */
+    const char* read_tag(
+                         const char* p,
+                         element& e) const;
+
+private:
+    const char* actual;
+    const char* end;
+};
+
+#endif /* !XML_SCANNER_HPP */
@@ -23,6 +23,7 @@
 
 #include "gted.hpp"
 #include "mapping.hpp"
+#include "profiler.hpp"
 
 
 using namespace std;
@@ -47,6 +48,7 @@ void gted::run(
                const strategy_table_type& _str)
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("gted");
     
     INFO("BEG: Running GTED for RNAs %s and %s", t1.name(), t2.name());
     
@@ -256,6 +258,7 @@ get_fdist(fdist, iter1, iter2, id1, id2)
 mapping gted::get_mapping()
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("gted mapping");
     
     INFO("BEG: Computing mapping between RNAs %s and %s",
          t1.name(), t2.name());
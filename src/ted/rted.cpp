@@ -21,6 +21,7 @@
 
 
 #include "rted.hpp"
+#include "profiler.hpp"
 
 #define RTED_BAD        size_t(-0xBADF00D)
 #define isbad(value)    ((value) == RTED_BAD)
@@ -43,6 +44,7 @@ rted::rted(
 void rted::run()
 {
     APP_DEBUG_FNAME;
+    PROFILE_STAGE("rted");
     
     init();
     
@@ -86,9 +88,6 @@ void rted::init()
     size1 = t1.size();
     size2 = t2.size();
     
-    t1.print_tree();
-    t2.print_tree();
-    
     // STR table:
     inner_str.resize(size2);
     STR.resize(size1, inner_str);
@@ -0,0 +1,120 @@
+/*
+ * File: app.test.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#include <sstream>
+
+#include "app.test.hpp"
+#include "app.hpp"
+#include "utils.hpp"
+
+#define TEMPLATE            "../tests/data/tmp/d.5.b.A.madurae"
+#define TARGET              "../tests/data/tgt/URS00000B9D9D_471852-d.5.b.A.madurae.fasta"
+#define OTHER_TARGET        "../tests/data/tgt/URS00000B14F2_575540-d.5.b.P.brasiliensis.fasta"
+#define TEST_MANIFEST       "/tmp/app-test-batch.tsv"
+#define TEST_OUTPUT         "/tmp/app-test"
+
+using namespace std;
+
+app_test::app_test()
+    : test("app")
+{ }
+
+void app_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_manifest();
+    test_batch();
+}
+
+void app_test::test_manifest()
+{
+    // template files with and without format, bundle, comments,
+    // empty lines and line ends of windows
+    istringstream in(
+        "# comment\n"
+        "t.ps\tt.fasta\tg.fasta\tout\r\n"
+        "\n"
+        "t.svg\tt.fasta\tg.fasta\tout2\tvarna\n"
+        "\r\n"
+        "t.bundle\tg.fasta\tout3");
+    vector<app::batch_job> jobs = app::read_batch_manifest(in, "manifest");
+    assert_equals(jobs.size(), 3);
+    assert_equals(jobs[0].line, 2);
+    assert_true(jobs[0].templated == vector<string>({"crw", "t.ps", "t.fasta"}));
+    assert_equals(jobs[0].targets, "g.fasta");
+    assert_equals(jobs[0].file, "out");
+    assert_equals(jobs[1].line, 4);
+    assert_true(jobs[1].templated == vector<string>({"varna", "t.svg", "t.fasta"}));
+    assert_equals(jobs[1].file, "out2");
+    assert_equals(jobs[2].line, 6);
+    assert_true(jobs[2].templated == vector<string>({"t.bundle"}));
+    assert_equals(jobs[2].targets, "g.fasta");
+    assert_equals(jobs[2].file, "out3");
+
+    // wrong number of columns fails whole manifest
+    for (const string& text : {"t.ps\tt.fasta\tg.fasta\tout\n" "t.bundle\tg.fasta\n",
+                               "t.ps\tt.fasta\tg.fasta\tout\tcrw\textra\n"})
+    {
+        istringstream wrong(text);
+        assert_fail(app::read_batch_manifest(wrong, "manifest"));
+    }
+}
+
+void app_test::test_batch()
+{
+    vector<string> suffixes = {".svg", ".colored.svg", ".ps", ".colored.ps", ".xml", ".json"};
+    for (const string& job : {"1", "2", "3"})
+        for (const string& suffix : suffixes)
+            remove((TEST_OUTPUT "-batch-" + job + suffix).c_str());
+
+    // job with missing target fails alone, the others are laid out
+    // as by separate runs, the batch exits with error
+    write_file(TEST_MANIFEST,
+               TEMPLATE ".ps\t" TEMPLATE ".fasta\t" TARGET "\t" TEST_OUTPUT "-batch-1\n"
+               TEMPLATE ".ps\t" TEMPLATE ".fasta\t" "/tmp/app-test-missing.fasta\t" TEST_OUTPUT "-batch-2\n"
+               TEMPLATE ".ps\t" TEMPLATE ".fasta\t" OTHER_TARGET "\t" TEST_OUTPUT "-batch-3\n");
+    try
+    {
+        app().run({"traveler", "--batch", TEST_MANIFEST, "--threads", "2"});
+        add_failed("batch with failing job should fail");
+    }
+    catch (const aplication_error& e)
+    {
+        int status = e.get_return_status();
+        assert_equals(status, ERROR_DEFAULT);
+    }
+
+    vector<pair<string, string>> pairs = {{TARGET, "1"}, {OTHER_TARGET, "3"}};
+    for (const auto& p : pairs)
+    {
+        app().run({"traveler", "--target-structure", p.first,
+            "--template-structure", TEMPLATE ".ps", TEMPLATE ".fasta", "--all", TEST_OUTPUT "-single"});
+
+        for (const string& suffix : suffixes)
+        {
+            string batch = TEST_OUTPUT "-batch-" + p.second + suffix;
+            assert_true(exist_file(batch));
+            assert_equals(read_file(batch), read_file(TEST_OUTPUT "-single" + suffix));
+        }
+    }
+    assert_false(exist_file(TEST_OUTPUT "-batch-2.svg"));
+}
@@ -0,0 +1,146 @@
+/*
+ * File: compact.test.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef TEST
+#define TEST
+#endif
+
+#include <thread>
+
+#include "compact.test.hpp"
+#include "compact.hpp"
+#include "traveler.hpp"
+#include "utils.hpp"
+
+#define TEMPLATE            "../tests/data/tmp/d.5.b.A.madurae"
+
+using namespace std;
+
+compact_test::compact_test()
+    : test("compact")
+{ }
+
+void compact_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_rounds();
+    test_reuse();
+}
+
+void compact_test::test_rounds()
+{
+    // rounds are scripted, each one moves a branch and lowers overlaps
+    // until `overlaps` runs out
+    rna_tree rna = traveler::load_template(TEMPLATE ".ps", "crw", TEMPLATE ".fasta");
+    vector<size_t> overlaps;
+    size_t counted = 0;
+    auto count_overlaps = [&overlaps, &counted]() { return overlaps.at(counted++); };
+    auto round = []() -> size_t { return 1; };
+
+    // round limit
+    {
+        layout_budget budget;
+        budget.max_iterations = 1;
+        compact c(rna, budget);
+        overlaps = {10, 8, 6, 4};
+        counted = 0;
+        c.run_rounds(round, count_overlaps);
+        assert_equals(c.get_stats().size(), 1);
+        assert_equals(c.get_stats()[0].overlaps, 8);
+    }
+
+    // without limits rounds run until overlaps stop decreasing
+    {
+        layout_budget budget;
+        budget.max_iterations = 0;
+        compact c(rna, budget);
+        overlaps = {10, 8, 6, 6};
+        counted = 0;
+        c.run_rounds(round, count_overlaps);
+        assert_equals(c.get_stats().size(), 3);
+        assert_false(c.get_stats().back().reverted);
+    }
+
+    // time budget is checked after each round
+    {
+        layout_budget budget;
+        budget.max_iterations = 0;
+        budget.time = 0.01;
+        compact c(rna, budget);
+        overlaps = {10, 8, 6, 4};
+        counted = 0;
+        c.run_rounds([]() -> size_t
+                     {
+                         this_thread::sleep_for(chrono::milliseconds(20));
+                         return 1;
+                     }, count_overlaps);
+        assert_equals(c.get_stats().size(), 1);
+        assert_true(c.get_stats()[0].time >= 0.01);
+    }
+
+    // round increasing overlaps is reverted and ends the loop
+    {
+        layout_budget budget;
+        budget.max_iterations = 0;
+        compact c(rna, budget);
+        overlaps = {10, 8, 9, 4};
+        counted = 0;
+        rna_tree::iterator moved = ++rna.begin();
+        point original = moved->at(0).p;
+        size_t rounds = 0;
+        c.run_rounds([&rna, &rounds]() -> size_t
+                     {
+                         // every round shifts first residue, only second is undone
+                         rna_tree::iterator it = ++rna.begin();
+                         it->at(0).p = it->at(0).p + point(100, 0);
+                         ++rounds;
+                         return 1;
+                     }, count_overlaps);
+        assert_equals(rounds, 2);
+        assert_equals(c.get_stats().size(), 2);
+        assert_false(c.get_stats()[0].reverted);
+        assert_true(c.get_stats()[1].reverted);
+        moved = ++rna.begin();
+        assert_true(moved->at(0).p == original + point(100, 0));
+    }
+}
+
+void compact_test::test_reuse()
+{
+    // template laid out by its own structure keeps its coordinates,
+    // there is nothing dirty for beautification to try either
+    fasta f = read_fasta_file(TEMPLATE ".fasta");
+    for (bool rotate : {false, true})
+    {
+        rna_tree templated = traveler::load_template(TEMPLATE ".ps", "crw", TEMPLATE ".fasta");
+        rna_tree target = traveler::build_target(">target\n" + f.labels + "\n" + f.brackets + "\n");
+        mapping m = traveler::compute_mapping(templated, target);
+
+        traveler::layout_options options;
+        options.rotate_branches = rotate;
+        traveler::layout_stats stats = traveler::layout(templated, target, m, options);
+        assert_equals(stats.reuse.processed + stats.reuse.reused, templated.size());
+        assert_true(stats.reuse.reused >= 0.95 * templated.size());
+        assert_equals(stats.reuse.processed, 0);
+    }
+}
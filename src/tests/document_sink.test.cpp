@@ -0,0 +1,196 @@
+/*
+ * File: document_sink.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <zlib.h>
+
+#include "document_sink.hpp"
+#include "document_writer.hpp"
+#include "utils.hpp"
+#include "document_sink.test.hpp"
+
+using namespace std;
+
+document_sink_test::document_sink_test()
+    : test("document_sink")
+{ }
+
+void document_sink_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_general();
+    test_fixed();
+    test_sink();
+    test_compression();
+    test_memory();
+}
+
+void document_sink_test::test_general()
+{
+    // formatter has to give same text as printf("%g"),
+    // ie. as std::ostream does with default flags
+    vector<double> values = {
+        0, -0., 1, -1, 0.5, 0.1, 1e-4, 9.99999e-5, 0.000123456, 123456,
+        999999, 999999.5, 1e6, 1234567, 100000, 99999.95, 0.00012345650,
+        2.5, 0.125, 1.0000005, 134.59813381662735, -27.1452, 1e300, NAN, INFINITY
+    };
+    srand(42);
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        double magnitude = pow(10., rand() % 14 - 6);
+        values.push_back((rand() - RAND_MAX / 2) / double(RAND_MAX) * magnitude);
+        // values with few decimal digits are the most likely ties
+        values.push_back((rand() % 2000000 - 1000000) / 1e4);
+    }
+
+    char expected[document_sink::number_buffer_size];
+    char formatted[document_sink::number_buffer_size];
+    size_t errors = 0;
+    for (double value : values)
+    {
+        snprintf(expected, sizeof(expected), "%g", value);
+        size_t length = document_sink::format_general(formatted, value);
+        if (string(formatted, length) != expected)
+        {
+            if (errors++ < 10)
+                ERR("TESTS %s: %%g of %.17g: expected %s, got %s",
+                    test_name, value, expected, string(formatted, length));
+        }
+    }
+    assert_equals(errors, 0);
+}
+
+void document_sink_test::test_fixed()
+{
+    vector<double> values = {0, -0., 0.005, 0.015, -0.001, 1.125, 2.675, 20, 31.838723, -412.795, 1e20};
+    srand(7);
+    for (size_t i = 0; i < 100000; ++i)
+        values.push_back((rand() % 20000000 - 10000000) / 1e5);
+
+    char expected[document_sink::number_buffer_size];
+    char formatted[document_sink::number_buffer_size];
+    size_t errors = 0;
+    for (int precision : {0, 2, 6})
+        for (double value : values)
+        {
+            snprintf(expected, sizeof(expected), "%.*f", precision, value);
+            size_t length = document_sink::format_fixed(formatted, value, precision);
+            if (string(formatted, length) != expected)
+            {
+                if (errors++ < 10)
+                    ERR("TESTS %s: %%.%sf of %.17g: expected %s, got %s",
+                        test_name, precision, value, expected, string(formatted, length));
+            }
+        }
+    assert_equals(errors, 0);
+}
+
+void document_sink_test::test_sink()
+{
+    document_sink sink;
+
+    sink << "x=\"" << 1.5 << "\" " << -42 << ' ' << string("ab");
+    size_t column = sink.size();
+    sink << 7;
+    sink.pad(column, 4);
+    sink.put_fixed(3.14159, 2);
+    column = sink.size();
+    sink << "long text";
+    sink.pad(column, 4);
+
+    assert_equals(string(sink.data(), sink.size()), "x=\"1.5\" -42 ab7   3.14long text");
+
+    sink.clear();
+    assert_equals(sink.size(), 0);
+}
+
+void document_sink_test::test_compression()
+{
+    const string filename = "/tmp/document-sink-test";
+    string expected;
+
+    // more than sink holds, so document is compressed in several writes
+    for (int i = 0; i < 20000; ++i)
+        expected += msprintf("<point x=\"%s\" y=\"%s\" b=\"A\"/>\n", i, i * 0.5);
+
+    for (bool compressed : {false, true})
+    {
+        auto writer = document_writer::get_traveler_writer();
+        writer->use_compression(compressed);
+        writer->init(filename, ".xml", "</structure>\n");
+        writer->print(expected);
+        writer->close();
+
+        const document_writer::write_stats& stats = writer->get_write_stats();
+        assert_equals(stats.file, compressed ? filename + ".xml.gz" : filename + ".xml");
+        assert_equals(stats.bytes, expected.size() + strlen("</structure>\n"));
+        if (compressed)
+        {
+            assert_true(stats.stored < stats.bytes);
+        }
+        else
+        {
+            assert_equals(stats.stored, stats.bytes);
+        }
+    }
+
+    gzFile in = gzopen((filename + ".xml.gz").c_str(), "rb");
+    assert_true(in != nullptr);
+    string decompressed;
+    char buffer[4096];
+    int read;
+    while ((read = gzread(in, buffer, sizeof(buffer))) > 0)
+        decompressed.append(buffer, read);
+    gzclose(in);
+
+    assert_equals(decompressed, read_file(filename + ".xml"));
+    assert_equals(decompressed, expected + "</structure>\n");
+}
+
+void document_sink_test::test_memory()
+{
+    const string filename = "/tmp/document-sink-memory-test";
+    string expected;
+    string document = "kept ";
+
+    for (int i = 0; i < 20000; ++i)
+        expected += msprintf("<point x=\"%s\"/>\n", i);
+
+    // document is appended to memory, compression is not used there
+    auto writer = document_writer::get_traveler_writer();
+    writer->use_compression(true);
+    writer->use_memory(&document);
+    writer->init(filename, ".xml", "</structure>\n");
+    writer->print(expected);
+    writer->close();
+
+    const document_writer::write_stats& stats = writer->get_write_stats();
+    assert_equals(document, "kept " + expected + "</structure>\n");
+    assert_equals(stats.file, filename + ".xml");
+    assert_equals(stats.stored, stats.bytes);
+    assert_false(exist_file(filename + ".xml"));
+    assert_false(exist_file(filename + ".xml.gz"));
+}
@@ -0,0 +1,431 @@
+/*
+ * File: extractor.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <regex>
+#include <glob.h>
+
+#include "extractor.test.hpp"
+#include "extractor.hpp"
+#include "utils.hpp"
+#include "xml_scanner.hpp"
+#include "layout_writer.hpp"
+#include "template_bundle.hpp"
+
+#define TEST_FILE           "/tmp/extractor-test.ps"
+#define TEST_XML_FILE       "/tmp/extractor-test.svg"
+#define TEST_LAYOUT_FILE    "/tmp/extractor-test"
+#define TEST_BUNDLE_FILE    "/tmp/extractor-test.bundle"
+#define BUNDLE_TEMPLATE     "../tests/data/tmp/d.5.b.A.madurae"
+#define CRW_TEMPLATES       "../tests/data/tmp/*.ps"
+#define METAZOA_TEMPLATES   "../data/metazoa/*.ps"
+#define VARNA_TEMPLATES     "../tests/data/tmp/*.svg"
+#define TRAVELER_TEMPLATES  "../tests/data/tmp/*.tr"
+
+using namespace std;
+
+static bool identical(
+            const vector<point>& v1,
+            const vector<point>& v2)
+{
+    if (v1.size() != v2.size())
+        return false;
+    for (size_t i = 0; i < v1.size(); ++i)
+        if (v1[i].x != v2[i].x || v1[i].y != v2[i].y)
+            return false;
+    return true;
+}
+
+/*
+ * same as extractor::mirror_y
+ */
+static void mirror(
+            vector<point>& points)
+{
+    double min_y = numeric_limits<double>::max();
+    double max_y = numeric_limits<double>::min();
+    for (const point& p : points)
+    {
+        min_y = min(min_y, p.y);
+        max_y = max(max_y, p.y);
+    }
+    for (point& p : points)
+        p.y = max_y + min_y - p.y;
+}
+
+extractor_test::extractor_test()
+    : test("extractor")
+{ }
+
+void extractor_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_crw_lines();
+    test_crw_templates();
+    test_xml_scanner();
+    test_xml_lines();
+    test_xml_templates();
+    test_layout();
+    test_template_bundle();
+}
+
+void extractor_test::test_crw_lines()
+{
+    string text =
+        "%!\n"
+        "(A) 1 2 lwstring\n"
+        "(b)\t-1.5  22.25 lwstring \r\n"
+        "(C) 1. 2 lwstring\n"
+        "(D) 1 2 lwstring x\n"
+        "(EE) 1 2 lwstring\n"
+        " (F) 1 2 lwstring\n"
+        "(G) 1 2lwstring\n"
+        "(H) -0.125 7 lwline\n"
+        "(1) 1 2 lwstring\n"
+        "(I) 3 4 lwstring";
+
+    write_file(TEST_FILE, text);
+
+    string labels;
+    vector<point> points;
+    extract_crw_regex(TEST_FILE, labels, points);
+    extractor_ptr crw = extractor::get_extractor(TEST_FILE, "crw");
+
+    assert_equals(labels, "AbI");
+    assert_equals(crw->labels, labels);
+    assert_true(identical(crw->points, points));
+}
+
+void extractor_test::test_crw_templates()
+{
+    compare_templates(CRW_TEMPLATES, "crw", extract_crw_regex);
+    compare_templates(METAZOA_TEMPLATES, "crw", extract_crw_regex);
+}
+
+void extractor_test::test_xml_scanner()
+{
+    string text =
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" [ <!ENTITY e \"<a>\"> ]>\n"
+        "<svg width=\"100%\">\n"
+        "<!-- <text x=\"1\" y=\"1\">A</text> -->"
+        "<text\n x = '1.5'\n\ty=\"-2\" label=\"a > b\" >\n C \n</text><g/>"
+        "<point x=3 y=4 b=\"G\"/><![CDATA[<point x=\"5\"/>]]>"
+        "</svg>";
+
+    xml_scanner xml(text.data(), text.data() + text.size());
+    xml_scanner::element el;
+    double value;
+
+    assert_true(xml.next(el));
+    assert_true(el.name == "svg");
+    assert_true(el.get("width") != nullptr && *el.get("width") == "100%");
+    assert_false(el.self_closing);
+
+    assert_true(xml.next(el));
+    assert_true(el.name == "text");
+    assert_equals(el.attributes.size(), 3);
+    assert_true(el.get("x")->to_double(value) && value == 1.5);
+    assert_true(el.get("y")->to_double(value) && value == -2);
+    assert_false(el.get("label")->to_double(value));
+    assert_true(el.get("b") == nullptr);
+    assert_true(el.text == "C");
+
+    assert_true(xml.next(el));
+    assert_true(el.name == "g");
+    assert_true(el.self_closing);
+    assert_true(el.text.size() == 0);
+
+    assert_true(xml.next(el));
+    assert_true(el.name == "point");
+    assert_true(el.get("x")->to_double(value) && value == 3);
+    assert_true(*el.get("b") == "G");
+
+    assert_false(xml.next(el));
+    assert_false(xml.next(el));
+}
+
+void extractor_test::test_xml_lines()
+{
+    // elements split across lines and several elements on one line
+    string text =
+        "<svg>\n"
+        "<text x=\"1\" y=\"2\" fill=\"rgb(0%, 0%, 0%)\" >A</text><text x=\"3\"\n"
+        "    y=\"4\">b</text>\n"
+        "<text x=\"5\" y=\"6\">10</text>\n"
+        "<text x=\"x\" y=\"6\">C</text>\n"
+        "<text y=\"8\" x=\"7\">\nG\n</text>\n"
+        "<point x=\"9\" y=\"10\" b=\"U\"/></svg>";
+
+    write_file(TEST_XML_FILE, text);
+
+    extractor_ptr varna = extractor::get_extractor(TEST_XML_FILE, "varna");
+    assert_equals(varna->labels, "AbG");
+    assert_true(varna->points.size() == 3 &&
+                varna->points[0].x == 1 && varna->points[1].x == 3 && varna->points[2].x == 7);
+    // y coordinates are mirrored
+    assert_true(varna->points[0].y == 8 && varna->points[1].y == 6 && varna->points[2].y == 2);
+
+    extractor_ptr traveler = extractor::get_extractor(TEST_XML_FILE, "traveler");
+    assert_equals(traveler->labels, "U");
+    assert_true(traveler->points.size() == 1 && traveler->points[0].x == 9);
+}
+
+void extractor_test::test_xml_templates()
+{
+    compare_templates(VARNA_TEMPLATES, "varna", extract_varna_regex);
+    compare_templates(TRAVELER_TEMPLATES, "traveler", extract_traveler_regex);
+}
+
+void extractor_test::test_layout()
+{
+    // layout written in both formats has to be read back exactly,
+    // coordinates are as computed by layout, ie. with all digits
+    const string bases = "GAC";
+    const point coordinates[] = {
+        point(440.15735103402147, -367.08129471273004),
+        point(0.1 + 0.2, 1e-9 / 3),
+        point(-1234.5, NAN)
+    };
+    rna_tree rna("(.)", bases, "layout \"test\"");
+    render_model model;
+    render_model::element e;
+    vector<point> points;
+
+    e.type = render_model::terminal;
+    e.label.label = "5'";
+    e.label.p = point(-1, -1);
+    model.elements.push_back(e);
+    for (int i = 0; i < 3; ++i)
+    {
+        e.type = render_model::label;
+        e.label.label = bases.substr(i, 1);
+        e.label.p = coordinates[i];
+        e.pair = i == 1 ? -1 : 2 - i;
+        e.info = label_info(i, "", i == 1 ? 0 : i + 1);
+        model.elements.push_back(e);
+        points.push_back(e.label.p);
+    }
+    e.type = render_model::base_pair;
+    model.elements.push_back(e);
+
+    for (layout_writer::format_type format : {layout_writer::json, layout_writer::binary})
+    {
+        layout_writer writer(format);
+        writer.init(TEST_LAYOUT_FILE, rna);
+        writer.print(model);
+        writer.close();
+
+        extractor_ptr layout = extractor::get_extractor(writer.get_write_stats().file, "layout");
+        assert_equals(layout->labels, bases);
+        assert_equals(layout->points.size(), points.size());
+        size_t different = 0;
+        for (size_t i = 0; i < min(points.size(), layout->points.size()); ++i)
+        {
+            const point& p = layout->points[i];
+            if (!(p.x == points[i].x || (isnan(p.x) && isnan(points[i].x))) ||
+                !(p.y == points[i].y || (isnan(p.y) && isnan(points[i].y))))
+                ++different;
+        }
+        assert_equals(different, 0);
+    }
+
+    assert_equals(read_file(TEST_LAYOUT_FILE ".json"),
+                  "{\"name\":\"layout \\\"test\\\"\",\"residues\":3,"
+                  "\"x\":[440.1573510340215,0.30000000000000004,-1234.5],"
+                  "\"y\":[-367.08129471273,3.3333333333333337e-10,null],\"base\":\"GAC\","
+                  "\"pair\":[2,-1,0],\"template\":[1,0,3]}\n");
+}
+
+void extractor_test::test_template_bundle()
+{
+    // template loaded from bundle has to be the same as the prepared one
+    extractor_ptr doc = extractor::get_extractor(BUNDLE_TEMPLATE ".ps", "crw");
+    fasta f = read_fasta_file(BUNDLE_TEMPLATE ".fasta");
+    doc->adjust_residues_lists(f.brackets.size());
+    rna_tree templated(f.brackets, doc->labels, doc->points, f.id);
+
+    template_bundle::save(templated, TEST_BUNDLE_FILE);
+    assert_true(template_bundle::is_bundle(TEST_BUNDLE_FILE));
+    rna_tree loaded = template_bundle::load(TEST_BUNDLE_FILE);
+
+    assert_equals(loaded.name(), templated.name());
+    assert_equals(loaded.size(), templated.size());
+    assert_equals(loaded.get_brackets(), templated.get_brackets());
+    assert_equals(loaded.get_labels(), templated.get_labels());
+    assert_true(loaded.get_pairs_distance() == templated.get_pairs_distance() &&
+                loaded.get_pair_base_distance() == templated.get_pair_base_distance() &&
+                loaded.get_loops_bases_distance() == templated.get_loops_bases_distance());
+
+    // labels and points including 5' and 3' ends at root
+    rna_tree::pre_post_order_iterator it1 = templated.begin_pre_post();
+    rna_tree::pre_post_order_iterator it2 = loaded.begin_pre_post();
+    size_t different = 0;
+    for (; it1 != templated.end_pre_post() && it2 != loaded.end_pre_post(); ++it1, ++it2)
+    {
+        const rna_label& l1 = it1->at(it1.label_index());
+        const rna_label& l2 = it2->at(it2.label_index());
+        if (l1.label != l2.label || !(l1.p == l2.p))
+            ++different;
+    }
+    assert_equals(different, 0);
+
+    assert_false(template_bundle::is_bundle(BUNDLE_TEMPLATE ".ps"));
+    assert_fail(template_bundle::load(BUNDLE_TEMPLATE ".ps"));
+}
+
+void extractor_test::compare_templates(
+                const std::string& pattern,
+                const std::string& type,
+                void (*reference)(const std::string&, std::string&, std::vector<point>&))
+{
+    // compares extractor with former regex extraction on all templates
+    // and reports time spent by both
+    LOGGER_PRIORITY_ON_FUNCTION(INFO);
+
+    typedef chrono::steady_clock clock;
+    double regex_time = 0, scanner_time = 0;
+    size_t bases = 0;
+
+    glob_t files;
+    if (::glob(pattern.c_str(), 0, nullptr, &files) != 0)
+    {
+        INFO("TESTS %s: no templates matching %s", test_name, pattern);
+        return;
+    }
+
+    for (size_t i = 0; i < files.gl_pathc; ++i)
+    {
+        string file = files.gl_pathv[i];
+        string labels;
+        vector<point> points;
+
+        auto begin = clock::now();
+        reference(file, labels, points);
+        auto middle = clock::now();
+        extractor_ptr ex = extractor::get_extractor(file, type);
+        auto end = clock::now();
+
+        regex_time += chrono::duration<double>(middle - begin).count();
+        scanner_time += chrono::duration<double>(end - middle).count();
+        bases += labels.size();
+
+        assert_true(labels.size() > 0);
+        assert_equals(ex->labels, labels);
+        assert_true(identical(ex->points, points));
+    }
+
+    INFO("TESTS %s: %s %s templates, %s bases: regex %s s, scanner %s s",
+         test_name, files.gl_pathc, type, bases, regex_time, scanner_time);
+
+    globfree(&files);
+}
+
+/* static */ void extractor_test::extract_crw_regex(
+                const std::string& filename,
+                std::string& labels,
+                std::vector<point>& points)
+{
+    ifstream in(filename);
+    regex regexp_base_line(msprintf("^\\(%s\\)\\s+%s\\s+%s\\s+lwstring\\s*$",
+                                    BASE_REGEX, DOUBLE_REGEX, DOUBLE_REGEX));
+    smatch match;
+    string line;
+
+    while (getline(in, line))
+    {
+        if (regex_search(line, match, regexp_base_line))
+        {
+            stringstream str;
+            string base;
+            point p;
+
+            str << match[1] << " " << match[2] << " " << match[4];
+            str >> base >> p.x >> p.y;
+
+            labels.push_back(base[0]);
+            points.push_back(p);
+        }
+    }
+}
+
+/* static */ void extractor_test::extract_varna_regex(
+                const std::string& filename,
+                std::string& labels,
+                std::vector<point>& points)
+{
+    ifstream in(filename);
+    regex regexp_base_line(msprintf("^<text.*\\s+x=['\"]%s['\"].*\\s+y=['\"]%s['\"]\\s+.*>%s</text>",
+                                    DOUBLE_REGEX, DOUBLE_REGEX, BASE_REGEX));
+    smatch match;
+    string line;
+
+    while (getline(in, line))
+    {
+        if (regex_search(line, match, regexp_base_line))
+        {
+            stringstream str;
+            string base;
+            point p;
+
+            str << match[1] << " " << match[3] << " " << match[5];
+            str >> p.x >> p.y >> base;
+
+            labels.push_back(base[0]);
+            points.push_back(p);
+        }
+    }
+    mirror(points);
+}
+
+/* static */ void extractor_test::extract_traveler_regex(
+                const std::string& filename,
+                std::string& labels,
+                std::vector<point>& points)
+{
+    ifstream in(filename);
+    regex base_line("\\s*<point\\s+x=\"(.+)\"\\s+y=\"(.+)\"\\s+b=\"(.+)\"\\s*/>");
+    smatch match;
+    string line;
+
+    while (getline(in, line))
+    {
+        if (regex_search(line, match, base_line))
+        {
+            stringstream str;
+            string base;
+            point p;
+
+            str << match[1] << " " << match[2] << " " << match[3];
+            str >> p.x >> p.y >> base;
+
+            labels.push_back(base[0]);
+            points.push_back(p);
+        }
+    }
+    mirror(points);
+}
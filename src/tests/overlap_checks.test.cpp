@@ -64,6 +64,9 @@ void overlap_checks_test::run()
             test_intersection(p1, p2, intersects[i++]);
 
     test_intersection({100, 0}, {10, -10}, true);
+
+    for (size_t n : {10, 100, 1000})
+        test_run(n);
 }
 
 void overlap_checks_test::test_intersection(
@@ -83,3 +86,42 @@ void overlap_checks_test::test_intersection(
     assert_equals(!intersection.bad(), intersects);
 }
 
+
+void overlap_checks_test::test_run(
+                size_t edges_count)
+{
+    // random walk backbone, grid search has to find same overlaps
+    // as comparing all pairs of edges
+    overlap_checks::edges edges;
+    overlap_checks::edge e;
+    srand(edges_count);
+
+    e.p1 = {0, 0};
+    e.id1 = 0;
+    for (size_t i = 1; i <= edges_count; ++i)
+    {
+        double alpha = rand() % 360;
+        e.p2 = move_point(e.p1, e.p1 + point(cos(alpha), sin(alpha)), 5 + rand() % 10);
+        e.id2 = i;
+        edges.push_back(e);
+        e.p1 = e.p2;
+        e.id1 = e.id2;
+    }
+
+    vector<point> expected;
+    for (size_t i = 0; i < edges.size(); ++i)
+        for (size_t j = i + 2; j < edges.size(); ++j)
+        {
+            if (edges[i] == edges[j] || edges[i].share_point(edges[j]))
+                continue;
+            point p = overlap_checks::intersection(edges[i], edges[j]);
+            if (!p.bad())
+                expected.push_back(p);
+        }
+
+    overlap_checks::overlaps found = overlap_checks().run(edges);
+
+    assert_equals(found.size(), expected.size());
+    for (size_t i = 0; i < min(found.size(), expected.size()); ++i)
+        assert_true(found[i].centre == expected[i]);
+}
@@ -0,0 +1,158 @@
+/*
+ * File: server.test.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef TEST
+#define TEST
+#endif
+
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.test.hpp"
+#include "server.hpp"
+#include "traveler.hpp"
+#include "utils.hpp"
+
+#define TEMPLATE            "../tests/data/tmp/d.5.b.A.madurae"
+#define TARGET              "../tests/data/tgt/URS00000B9D9D_471852-d.5.b.A.madurae.fasta"
+#define TEST_BUNDLE         "/tmp/server-test.bundle"
+
+using namespace std;
+
+server_test::server_test()
+    : test("server")
+{ }
+
+void server_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_parse_request();
+    test_handle();
+}
+
+void server_test::test_parse_request()
+{
+    server::request r = server::parse_request(
+        "template d.5\r\n"
+        "format json\n"
+        "colored 1\n"
+        "overlaps 0\n"
+        "rotate 1\n"
+        "timeout 2.5\n"
+        "\r\n"
+        ">target\nGAAAC\n(...)\n");
+    assert_equals(r.templated, "d.5");
+    assert_equals(r.format, "json");
+    assert_true(r.colored && !r.overlaps && r.rotate);
+    assert_equals(r.timeout, 2.5);
+    assert_equals(r.target, ">target\nGAAAC\n(...)\n");
+
+    r = server::parse_request("template d.5\n\n");
+    assert_equals(r.format, "svg");
+    assert_equals(r.timeout, 0);
+    assert_equals(r.target, "");
+
+    // unknown key, bad flag, bad timeouts, missing template,
+    // missing empty line and unknown format
+    assert_fail(server::parse_request("template d.5\ncolor 1\n\n"));
+    assert_fail(server::parse_request("template d.5\ncolored yes\n\n"));
+    assert_fail(server::parse_request("template d.5\ntimeout 0\n\n"));
+    assert_fail(server::parse_request("template d.5\ntimeout 1s\n\n"));
+    assert_fail(server::parse_request("template d.5\ntimeout\n\n"));
+    assert_fail(server::parse_request("format svg\n\n"));
+    assert_fail(server::parse_request("template d.5\nformat svg\n"));
+    assert_fail(server::parse_request("template d.5\nformat pdf\n\n"));
+}
+
+void server_test::test_handle()
+{
+    rna_tree templated = traveler::load_template(TEMPLATE ".ps", "crw", TEMPLATE ".fasta");
+    traveler::save_template_bundle(templated, TEST_BUNDLE);
+
+    server::options opts;
+    opts.templates["d.5"] = TEST_BUNDLE;
+    opts.threads = 1;
+    server s(opts);
+
+    string target = read_file(TARGET);
+    string response;
+
+    // layout runs out of time and goes on in background,
+    // while it runs there is no room for other timed requests
+    response = send_request(s, "template d.5\ntimeout 0.000001\n\n" + target);
+    assert_equals(response.compare(0, 24, "ERROR Request timed out "), 0);
+    response = send_request(s, "template d.5\ntimeout 60\n\n" + target);
+    assert_equals(response.compare(0, 20, "ERROR Server is busy"), 0);
+
+    // requests without time limit are not refused
+    response = send_request(s, "template d.5\n\n" + target);
+    assert_equals(response.compare(0, 3, "OK "), 0);
+    assert_true(response.find("\nSTATS {\"residues\": ") != string::npos);
+    assert_true(response.find("\"reused\": ") != string::npos);
+
+    // finished background layout frees its place
+    for (size_t i = 0; i < 1000 && s.abandoned != 0; ++i)
+        this_thread::sleep_for(chrono::milliseconds(10));
+    assert_equals(s.abandoned, 0);
+    response = send_request(s, "template d.5\ntimeout 60\n\n" + target);
+    assert_equals(response.compare(0, 3, "OK "), 0);
+
+    response = send_request(s, "template d.6\n\n" + target);
+    assert_equals(response, "ERROR Unknown template d.6\n");
+}
+
+/* static */ std::string server_test::send_request(
+                                                  server& s,
+                                                  const std::string& text)
+{
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+        throw io_exception("Creating socket pair failed");
+
+    // response can be larger than socket buffer, it is read meanwhile
+    thread handling([&s, &sockets]()
+                    {
+                        s.handle(sockets[1]);
+                        ::close(sockets[1]);
+                    });
+
+    for (size_t sent = 0; sent < text.size(); )
+    {
+        ssize_t written = ::write(sockets[0], text.data() + sent, text.size() - sent);
+        if (written <= 0)
+            break;
+        sent += written;
+    }
+    shutdown(sockets[0], SHUT_WR);
+
+    string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = ::read(sockets[0], buffer, sizeof(buffer))) > 0)
+        response.append(buffer, received);
+
+    handling.join();
+    ::close(sockets[0]);
+    return response;
+}
@@ -0,0 +1,90 @@
+/*
+ * File: spatial_index.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "spatial_index.hpp"
+#include "spatial_index.test.hpp"
+
+using namespace std;
+
+spatial_index_test::spatial_index_test()
+    : test("spatial_index")
+{ }
+
+void spatial_index_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    spatial_index empty;
+    assert_false(empty.any_point(rectangle({0, 0}, {10, 10})));
+    assert_false(empty.any_line(rectangle({0, 0}, {10, 10})));
+
+    spatial_index index({{5, 5}, point::bad_point()}, {{{-10, 2}, {20, 2}}}, 1);
+    assert_true(index.any_point(rectangle({0, 0}, {10, 10})));
+    assert_false(index.any_point(rectangle({6, 6}, {10, 10})));
+    // line crossing rectangle without end points in it
+    assert_true(index.any_line(rectangle({0, 0}, {10, 10})));
+    assert_false(index.any_line(rectangle({0, 3}, {10, 10})));
+    assert_false(index.any_line(rectangle({0, 0}, {10, 10}),
+                [](const spatial_index::line& l) { return l.first.x > 0; }));
+
+    for (size_t n : {10, 100, 1000})
+        test_queries(n);
+}
+
+void spatial_index_test::test_queries(
+                size_t count)
+{
+    // random points and lines, index has to answer same as linear scan
+    vector<point> points;
+    vector<spatial_index::line> lines;
+    srand(count);
+
+    auto random_point =
+    [count]()
+    {
+        return point(rand() % (10 * count), rand() % (10 * count));
+    };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        point p = random_point();
+        points.push_back(p);
+        lines.push_back({p, p + point(rand() % 30, rand() % 30 - 15)});
+    }
+
+    spatial_index index(points, lines, 10);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        point p = random_point();
+        rectangle r(p, p + point(1 + rand() % 20, 1 + rand() % 20));
+
+        bool has_point = false, has_line = false;
+        for (const point& q : points)
+            has_point = has_point || r.has(q);
+        for (const auto& l : lines)
+            has_line = has_line || r.intersects(l.first, l.second);
+
+        assert_equals(index.any_point(r), has_point);
+        assert_equals(index.any_line(r), has_line);
+    }
+}
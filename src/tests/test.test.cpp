@@ -24,12 +24,19 @@
 #include "types.hpp"
 #include "point.test.hpp"
 #include "rna_tree.test.hpp"
+#include "compact.test.hpp"
 #include "compact_circle.test.hpp"
 #include "gted.test.hpp"
 #include "rted.test.hpp"
 #include "overlap_checks.test.hpp"
+#include "spatial_index.test.hpp"
 #include "utils.test.hpp"
+#include "extractor.test.hpp"
+#include "document_sink.test.hpp"
 #include "mprintf.test.hpp"
+#include "traveler.test.hpp"
+#include "app.test.hpp"
+#include "server.test.hpp"
 
 using namespace std;
 
@@ -41,12 +48,19 @@ using namespace std;
     std::vector<test*> vec = {
         new test_point(),
         new rna_tree_test(),
+        new compact_test(),
         new compact_circle_test(),
         new gted_test(),
         new rted_test(),
         new overlap_checks_test(),
+        new spatial_index_test(),
         new utils_test(),
+        new extractor_test(),
+        new document_sink_test(),
         new mprinf_test(),
+        new traveler_test(),
+        new app_test(),
+        new server_test(),
     };
 
     for (test* t : vec)
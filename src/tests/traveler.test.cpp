@@ -0,0 +1,116 @@
+/*
+ * File: traveler.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <future>
+
+#include "traveler.hpp"
+#include "traveler.test.hpp"
+#include "job_context.hpp"
+#include "utils.hpp"
+
+#define TEMPLATE            "../tests/data/tmp/d.5.b.A.madurae"
+#define OTHER_TEMPLATE      "../tests/data/tmp/d.5.b.P.brasiliensis"
+// each layout is run this many times at once
+#define CONCURRENT_RUNS     3
+
+using namespace std;
+
+traveler_test::traveler_test()
+    : test("traveler")
+{ }
+
+void traveler_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_pipeline();
+    test_concurrent();
+
+    assert_true(traveler::get_format("json") == traveler::json);
+    assert_fail(traveler::get_format("pdf"));
+    assert_fail(traveler::build_target(string("\n")));
+}
+
+void traveler_test::test_pipeline()
+{
+    // template laid out by its own structure, given as text in memory
+    fasta f = read_fasta_file(TEMPLATE ".fasta");
+    rna_tree templated = traveler::load_template(TEMPLATE ".ps", "crw", TEMPLATE ".fasta");
+    rna_tree target = traveler::build_target(">target\n" + f.labels + "\n" + f.brackets + "\n");
+
+    mapping m = traveler::compute_mapping(templated, target);
+    assert_equals(m.distance, 0);
+
+    traveler::layout(templated, target, m, traveler::layout_options());
+    assert_equals(templated.get_brackets(), f.brackets);
+    assert_equals(templated.get_labels(), f.labels);
+
+    render_model model = traveler::get_render_model(templated, numbering_def());
+    string svg = traveler::render(templated, model, traveler::svg, false);
+    assert_equals(svg.compare(0, 4, "<svg"), 0);
+    assert_equals(traveler::render(templated, model, traveler::svg, false), svg);
+    assert_false(traveler::render(templated, model, traveler::json, true).empty());
+}
+
+void traveler_test::test_concurrent()
+{
+    // whole layout of `target` by `templated` in its own job,
+    // root label of target tree shows id it got
+    auto lay_out = [](const string& templatefile, const string& targetfile)
+    {
+        job_context context(targetfile);
+        job_context::scope entered(context);
+
+        rna_tree templated = traveler::load_template(templatefile + ".ps", "crw", templatefile + ".fasta");
+        rna_tree target = traveler::build_target(read_fasta_file(targetfile + ".fasta"));
+        mapping m = traveler::compute_mapping(templated, target);
+        traveler::layout(templated, target, m, traveler::layout_options());
+
+        render_model model = traveler::get_render_model(templated, numbering_def(),
+                                                        traveler::find_overlaps(templated));
+        return label(target.begin()) + "\n" +
+            traveler::render(templated, model, traveler::ps, true) +
+            traveler::render(templated, model, traveler::svg, false);
+    };
+    vector<pair<string, string>> layouts = {
+        {TEMPLATE, TEMPLATE},
+        {TEMPLATE, OTHER_TEMPLATE},
+        {OTHER_TEMPLATE, TEMPLATE},
+    };
+
+    vector<string> serial;
+    for (const auto& l : layouts)
+        serial.push_back(lay_out(l.first, l.second));
+
+    vector<future<string>> concurrent;
+    for (size_t i = 0; i < CONCURRENT_RUNS; ++i)
+        for (const auto& l : layouts)
+            concurrent.push_back(async(launch::async, lay_out, l.first, l.second));
+
+    for (size_t i = 0; i < concurrent.size(); ++i)
+    {
+        string document = concurrent[i].get();
+        assert_true(document == serial[i % layouts.size()]);
+    }
+    // template is the first tree of its job, target the second one
+    assert_equals(serial[0].compare(0, 7, "ROOT_1\n"), 0);
+}
@@ -21,11 +21,15 @@
 
 
 #include <fstream>
+#include <zlib.h>
 
 #include "utils.test.hpp"
 #include "utils.hpp"
+#include "structure_reader.hpp"
+#include "profiler.hpp"
 
 #define TEST_FILE "/tmp/utils-test"
+#define TEST_LOG_FILE "/tmp/utils-test.log"
 
 using namespace std;
 
@@ -47,6 +51,11 @@ void utils_test::run()
     test_exist_file();
     test_io();
     test_read_fasta_file();
+    test_structure_reader();
+    test_compressed_structures();
+    test_brackets();
+    test_profiler();
+    test_logger();
 }
 
 void utils_test::test_exist_file()
@@ -78,6 +87,234 @@ void utils_test::test_read_fasta_file()
     assert_fail(read_fasta_file(TEST_FILE));
 }
 
+void utils_test::test_structure_reader()
+{
+    vector<fasta> records;
+
+    // several fasta records, structure lines are recognized by brackets
+    records = read_structures(
+        ">first description\nGGGAAACCC\n(((...)))\n"
+        ">second\r\nACGU\r\nAC\r\n.()."
+        "\r\n");
+    assert_equals(records.size(), 2);
+    assert_equals(records[0].id, "first");
+    assert_equals(records[0].brackets, "(((...)))");
+    assert_equals(records[1].labels, "ACGUAC");
+    assert_equals(records[1].brackets, ".().");
+
+    // BPSEQ with CRW header, pseudoknot crosses the hairpin
+    records = read_structures(
+        "Filename: d.5.test.bpseq\n"
+        "Organism: Escherichia coli\n"
+        "1 G 6\n2 C 8\n3 A 0\n4 U 0\n5 A 0\n6 C 1\n7 A 0\n8 G 2\n"
+        "Filename: other.bpseq\n"
+        "1 A 2\n2 U 1\n");
+    assert_equals(records.size(), 2);
+    assert_equals(records[0].id, "d.5.test");
+    assert_equals(records[0].labels, "GCAUACAG");
+    assert_equals(records[0].brackets, "([...).]");
+    assert_equals(records[1].id, "other");
+    assert_equals(records[1].brackets, "()");
+
+    // two CT records
+    records = read_structures(
+        "4 ENERGY = -1.0 hairpin\n"
+        "1 G 0 2 4 1\n2 A 1 3 0 2\n3 A 2 4 0 3\n4 C 3 0 1 4\n"
+        "3 plain\n"
+        "1 A 0 2 0 1\n2 C 1 3 0 2\n3 U 2 0 0 3\n");
+    assert_equals(records.size(), 2);
+    assert_equals(records[0].id, "hairpin");
+    assert_equals(records[0].labels, "GAAC");
+    assert_equals(records[0].brackets, "(..)");
+    assert_equals(records[1].brackets, "...");
+
+    // Stockholm: interleaved blocks, gap columns, own structure of sequence,
+    // pseudoknot in letters and pair broken by a gap
+    records = read_structures(
+        "# STOCKHOLM 1.0\n"
+        "#=GF ID test\n"
+        "\n"
+        "seq1   GCAU\n"
+        "seq2   GC.U\n"
+        "#=GR seq2 SS ...<\n"
+        "#=GC SS_cons <A.>\n"
+        "\n"
+        "seq1   GC-\n"
+        "seq2   AGA\n"
+        "#=GC SS_cons a<>\n"
+        "#=GR seq2 SS ..>\n"
+        "//\n");
+    assert_equals(records.size(), 2);
+    assert_equals(records[0].id, "seq1");
+    assert_equals(records[0].labels, "GCAUGC");
+    assert_equals(records[0].brackets, "([.)].");
+    assert_equals(records[1].labels, "GCUAGA");
+    assert_equals(records[1].brackets, "..(..)");
+
+    assert_true(structure_reader(TEST_FILE).get_format() == structure_reader::stockholm);
+    assert_equals(read_structures("").size(), 0);
+
+    // structure kept in memory, without line break at the end
+    fasta text = structure_reader::read_text("1 G 3\n2 A 0\n3 C 1", "request");
+    assert_equals(text.id, "request");
+    assert_equals(text.brackets, "(.)");
+    assert_fail(structure_reader::read_text("\n", "request"));
+    assert_fail(read_structures("1 A 2\n2 U 0\n"));
+}
+
+void utils_test::test_compressed_structures()
+{
+    APP_DEBUG_FNAME;
+
+    // long wrapped record makes reader refill its buffer in the middle
+    // of records, short ones follow it
+    vector<fasta> expected;
+    string text;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        fasta f;
+        f.id = "record_" + to_string(i);
+        size_t stems = i == 0 ? 50000 : i;
+        f.labels = string(stems, 'G') + "AAA" + string(stems, 'C');
+        f.brackets = string(stems, '(') + "..." + string(stems, ')');
+        expected.push_back(f);
+
+        text += ">" + f.id + "\n";
+        for (size_t j = 0; j < f.labels.size(); j += 60)
+            text += f.labels.substr(j, 60) + "\n";
+        text += f.brackets + "\n";
+    }
+
+    gzFile out = gzopen(TEST_FILE, "wb");
+    assert_true(out != nullptr);
+    assert_equals(gzwrite(out, text.data(), text.size()), int(text.size()));
+    assert_equals(gzclose(out), Z_OK);
+
+    structure_reader reader(TEST_FILE);
+    assert_true(reader.get_format() == structure_reader::dot_bracket);
+
+    fasta f;
+    size_t count = 0;
+    while (reader.next(f))
+    {
+        {
+            assert_true(count < expected.size() && f == expected[count]);
+        }
+        ++count;
+    }
+    assert_equals(count, expected.size());
+}
+
+void utils_test::test_brackets()
+{
+    // nested pairs, two crossing levels and pair crossing all levels
+    assert_equals(structure_reader::get_brackets({-1, 3, -1, 1}), ".(.)");
+    assert_equals(structure_reader::get_brackets({4, 6, 8, 9, 0, 7, 1, 5, 2, 3}), "([{.)(])}.");
+    assert_true(structure_reader::get_wuss_pairs("<<A>>a,.") == vector<int>({4, 3, 5, 1, 0, 2, -1, -1}));
+    assert_fail(structure_reader::get_wuss_pairs("<<>"));
+}
+
+vector<fasta> utils_test::read_structures(
+                const std::string& text)
+{
+    write_file(TEST_FILE, text);
+
+    structure_reader reader(TEST_FILE);
+    vector<fasta> records;
+    fasta f;
+    while (reader.next(f))
+        records.push_back(f);
+    return records;
+}
+
+void utils_test::test_profiler()
+{
+    // disabled profiler records nothing
+    {
+        PROFILE_STAGE("test stage");
+    }
+    assert_true(profiler::get_stages().empty());
+
+    profiler::enable();
+    for (size_t i = 0; i < 2; ++i)
+    {
+        PROFILE_STAGE("test stage");
+        vector<int> allocated(1000);
+    }
+    vector<profiler::stage> stages = profiler::get_stages();
+    assert_equals(stages.size(), 1);
+    assert_equals(stages[0].name, "test stage");
+    assert_equals(stages[0].calls, 2);
+    assert_true(stages[0].allocations >= 2 && stages[0].allocated_bytes >= 2000 * sizeof(int));
+    assert_true(stages[0].wall >= 0 && stages[0].peak_rss > 0);
+    assert_true(profiler::to_json().find("\"name\": \"test stage\", \"calls\": 2") != string::npos);
+
+    // hardware counters are optional, unavailable ones are reported
+    bool counting = profiler::enable_counters();
+    assert_equals(counting, profiler::is_counting());
+    {
+        PROFILE_STAGE("counted stage");
+        vector<int> allocated(1000);
+    }
+    // stage is scaled by its own share of counting time, here events
+    // ran 1/4 of the first 1000 ns and all of the next 1000 ns
+    profiler::counter_sample from, to;
+    profiler::counter_values delta;
+    from.values[profiler::cycles] = 100;
+    from.enabled = 1000;
+    from.running = 250;
+    to.values[profiler::cycles] = 1100;
+    to.enabled = 2000;
+    to.running = 1250;
+    profiler::get_counters_delta(from, to, delta);
+    assert_equals(delta[profiler::cycles], 1000);
+    assert_equals(delta[profiler::instructions], 0);
+    profiler::get_counters_delta(to, from, delta);
+    assert_equals(delta[profiler::cycles], 0);
+
+    string json = profiler::to_json();
+    if (counting)
+    {
+        assert_true(json.find("\"counters\": [\"") != string::npos);
+    }
+    else
+    {
+        assert_true(json.find("\"counters_error\": ") != string::npos);
+    }
+
+    profiler::disable();
+    profiler::clear();
+}
+
+void utils_test::test_logger()
+{
+    remove(TEST_LOG_FILE);
+    {
+        // more messages than fits in queue of writer thread
+        class logger l(TEST_LOG_FILE, logger::INFO);
+        for (size_t i = 0; i < 3 * LOGGER_QUEUE_SIZE; ++i)
+        {
+            l.info("message %s", i);
+            l.debug("hidden %s", i);
+        }
+        l.flush();
+        l.warn("last");
+    }
+
+    ifstream in(TEST_LOG_FILE);
+    string line;
+    size_t count = 0;
+    while (getline(in, line))
+    {
+        string expected = count < 3 * LOGGER_QUEUE_SIZE ?
+            "[INFO]  message " + to_string(count) : "[WARN]  last";
+        assert_equals(line.substr(13), expected);
+        assert_true(line.size() > 12 && line[2] == ':' && line[12] == ' ');
+        ++count;
+    }
+    assert_equals(count, 3 * LOGGER_QUEUE_SIZE + 1);
+}
+
 fasta utils_test::create_fasta()
 {
     fasta f;
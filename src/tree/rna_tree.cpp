@@ -114,6 +114,27 @@ void rna_tree::update_points(
     set_53_labels(*this);
 }
 
+void rna_tree::restore_points(
+                              const std::vector<point>& points,
+                              double pairs_distance,
+                              double pair_base_distance,
+                              double loops_bases_distance)
+{
+    APP_DEBUG_FNAME;
+    
+    pre_post_order_iterator it;
+    size_t i = 0;
+    
+    for (it = ++begin_pre_post();
+         it != end_pre_post() && i < points.size();
+         ++it, ++i)
+        it->set_p(points[i], it.label_index());
+    
+    assert(i == points.size() && ++pre_post_order_iterator(it) == end_pre_post());
+    
+    distances = {pairs_distance, pair_base_distance, loops_bases_distance};
+}
+
 //highlights 5' and 3' end
 void set_53_labels(
         rna_tree &rna)
@@ -518,7 +539,7 @@ vector<rectangle> get_non_leaf_children_bounding_objects(rna_tree::iterator node
     vector<rectangle> bo;
     for (auto it = node.begin(); it != node.end(); it++) {
         if (!rna_tree::is_leaf(it)) {
-            auto aux = it->get_bounding_objects();
+            const auto& aux = it->get_bounding_objects();
             bo.insert(bo.end(), aux.begin(), aux.end());
         }
     }
@@ -539,37 +560,57 @@ rectangle get_loop_bounding_object(rna_tree::iterator node){
     return bo;
 }
 
-void rna_tree::update_bounding_boxes(bool leafs_have_size){
-    float bd = leafs_have_size ? get_pairs_distance()/2: 0;
-    for (post_order_iterator it = this->begin_post(); it != this->end_post(); ++it){
-        assert(it->initiated_points());
-
-        if (rna_tree::is_leaf(it)) {
-            //for a leaf, the bounding object is the list itself
-            if (it->paired()) {
-                //it can happen that the hairpin does not have a loop
-                it->set_bounding_objects(rectangle(it->at(0).p, it->at(1).p));
-            } else {
-//                it->set_bounding_objects(rectangle(it->at(0).p, it->at(0).p));
-                it->set_bounding_objects(rectangle(it->at(0).p+point(-bd, bd), it->at(0).p+point(bd, -bd)));
-            }
+static void update_bounding_box(rna_tree::iterator it, float bd){
+    assert(it->initiated_points());
+
+    if (rna_tree::is_leaf(it)) {
+        //for a leaf, the bounding object is the list itself
+        if (it->paired()) {
+            //it can happen that the hairpin does not have a loop
+            it->set_bounding_objects(rectangle(it->at(0).p, it->at(1).p));
         } else {
-            if (it.number_of_children() == 1) {
-                //the current node is continuation of a stem
-                vector<rectangle> bo =  it.begin()->get_bounding_objects();
-                bo[0] += rectangle(it->at(0).p, it->at(1).p);
-                it->set_bounding_objects(bo);
-            } else {
-                //the current node is the beginning of a (possibly multibranch) loop
-                it->set_bounding_objects(rectangle(it->at(0).p, it->at(1).p));
-                it->add_bounding_objects(get_loop_bounding_object(it));
-                // add boundin objects of the stems which begin in the current loop
-                it->add_bounding_objects(get_non_leaf_children_bounding_objects(it));
-            }
+//            it->set_bounding_objects(rectangle(it->at(0).p, it->at(0).p));
+            it->set_bounding_objects(rectangle(it->at(0).p+point(-bd, bd), it->at(0).p+point(bd, -bd)));
+        }
+    } else {
+        if (it.number_of_children() == 1) {
+            //the current node is continuation of a stem
+            vector<rectangle> bo =  it.begin()->get_bounding_objects();
+            bo[0] += rectangle(it->at(0).p, it->at(1).p);
+            it->set_bounding_objects(bo);
+        } else {
+            //the current node is the beginning of a (possibly multibranch) loop
+            it->set_bounding_objects(rectangle(it->at(0).p, it->at(1).p));
+            it->add_bounding_objects(get_loop_bounding_object(it));
+            // add boundin objects of the stems which begin in the current loop
+            it->add_bounding_objects(get_non_leaf_children_bounding_objects(it));
         }
     }
 }
 
+void rna_tree::update_bounding_boxes(bool leafs_have_size){
+    float bd = leafs_have_size ? get_pairs_distance()/2: 0;
+    for (post_order_iterator it = this->begin_post(); it != this->end_post(); ++it)
+        update_bounding_box(it, bd);
+}
+
+void rna_tree::update_bounding_boxes(iterator root, bool leafs_have_size){
+    float bd = leafs_have_size ? get_pairs_distance()/2: 0;
+
+    post_order_iterator it = root;
+    post_order_iterator end = root;
+    ++end;
+    it.descend_all();
+    for (; it != end; ++it)
+        update_bounding_box(it, bd);
+
+    // bounding objects of ancestors contain those of `root`
+    while (!is_root(root)) {
+        root = parent(root);
+        update_bounding_box(root, bd);
+    }
+}
+
 rna_pair_label rna_tree::get_node_by_id(const int id) {
     for (post_order_iterator it = this->begin_post(); it != this->end_post(); ++it) {
         if (it->id() == id) {
@@ -22,6 +22,7 @@
 
 #include "tree_matcher.hpp"
 #include "mapping.hpp"
+#include "profiler.hpp"
 
 using namespace std;
 
@@ -38,6 +39,7 @@ matcher::matcher(
 rna_tree& matcher::run(
                        const mapping& map)
 {
+    PROFILE_STAGE("matcher");
     INFO("BEG: Transforming trees with mapping function");
 
 //    post_order_iterator it = t1.begin_post();
@@ -119,8 +121,6 @@ void matcher::mark(
         it->status = status;
         i = index;
     }
-    
-    rna.print_tree();
 }
 
 void matcher::erase()
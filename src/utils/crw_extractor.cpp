@@ -20,14 +20,103 @@
  */
 
 
-#include <fstream>
+#include <cstring>
+#include <cstdlib>
 
 #include "crw_extractor.hpp"
 #include "types.hpp"
+#include "utils.hpp"
 
 
 using namespace std;
 
+/*
+ * Scanner for base lines of CRW PostScript document, accepts
+ * same lines as regex
+ *      ^\(BASE_REGEX\)\s+DOUBLE_REGEX\s+DOUBLE_REGEX\s+lwstring\s*$
+ * Every function gets actual position `p` and end of line `e`,
+ * returns position after accepted part or nullptr.
+ */
+namespace
+{
+    inline bool is_space(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r';
+    }
+    
+    inline bool is_digit(char ch)
+    {
+        return ch >= '0' && ch <= '9';
+    }
+    
+    inline bool is_alpha(char ch)
+    {
+        return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+    }
+    
+    // \s+
+    const char* skip_spaces(const char* p, const char* e)
+    {
+        if (p == e || !is_space(*p))
+            return nullptr;
+        while (p != e && is_space(*p))
+            ++p;
+        return p;
+    }
+    
+    const char* skip_digits(const char* p, const char* e)
+    {
+        if (p == e || !is_digit(*p))
+            return nullptr;
+        while (p != e && is_digit(*p))
+            ++p;
+        return p;
+    }
+    
+    // -?[0-9]+(\.[0-9]+)?
+    const char* scan_double(const char* p, const char* e, double& value)
+    {
+        const char* begin = p;
+        if (p != e && *p == '-')
+            ++p;
+        if ((p = skip_digits(p, e)) == nullptr)
+            return nullptr;
+        if (p != e && *p == '.' && (p = skip_digits(p + 1, e)) == nullptr)
+            return nullptr;
+        // number has to be followed by space in line,
+        // so strtod stops on the same character
+        if (p == e || !is_space(*p))
+            return nullptr;
+        value = strtod(begin, nullptr);
+        return p;
+    }
+    
+    bool scan_base_line(const char* p, const char* e, char& base, point& pos)
+    {
+        static const char keyword[] = "lwstring";
+        static const size_t keyword_length = sizeof(keyword) - 1;
+        
+        if (e - p < 3 || p[0] != '(' || !is_alpha(p[1]) || p[2] != ')')
+            return false;
+        base = p[1];
+        p += 3;
+        
+        if ((p = skip_spaces(p, e)) == nullptr ||
+            (p = scan_double(p, e, pos.x)) == nullptr ||
+            (p = skip_spaces(p, e)) == nullptr ||
+            (p = scan_double(p, e, pos.y)) == nullptr ||
+            (p = skip_spaces(p, e)) == nullptr)
+            return false;
+        
+        if (size_t(e - p) < keyword_length || memcmp(p, keyword, keyword_length) != 0)
+            return false;
+        for (p += keyword_length; p != e; ++p)
+            if (!is_space(*p))
+                return false;
+        
+        return true;
+    }
+}
 
 void crw_extractor::extract(
                             const std::string& filename)
@@ -37,40 +126,25 @@ void crw_extractor::extract(
     labels.clear();
     points.clear();
     
-    ifstream in(filename);
+    mapped_file file(filename);
+    const char* p = file.begin();
+    const char* end = file.end();
+    char base;
+    point pos;
     
-    regex regexp_base_line = create_regex(
-                                          msprintf("^\\(%s\\)\\s+%s\\s+%s\\s+lwstring\\s*$",
-                                                   BASE_REGEX, DOUBLE_REGEX, DOUBLE_REGEX));
-    
-    smatch match;
-    string line;
-    point p;
-    string base;
-    
-    while (true)
+    while (p != end)
     {
-        getline(in, line);
-        if (in.fail())
-            break;
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (eol == nullptr)
+            eol = end;
         
-        if (regex_search(line, match, regexp_base_line))
+        if (scan_base_line(p, eol, base, pos))
         {
-            // is base line
-            stringstream str;
-            
-            str << match[1] << " " << match[2] << " " << match[4];
-            
-            str
-            >> base
-            >> p.x
-            >> p.y;
-            
-            assert(!str.fail() && str.eof() && base.size() == 1);
-            
-            labels.push_back(base[0]);
-            points.push_back(p);
+            labels.push_back(base);
+            points.push_back(pos);
         }
+        
+        p = eol == end ? end : eol + 1;
     }
 }
 
@@ -0,0 +1,201 @@
+/*
+ * File: document_sink.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "document_sink.hpp"
+
+// significant digits of printf("%g")
+#define GENERAL_PRECISION       6
+
+using namespace std;
+
+namespace
+{
+    const double powers_of_ten[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+    };
+
+    /*
+     * rounds `scaled` to integer, returns false if it is too close to a tie
+     * to be decided from inexact `scaled`; then printf has to decide
+     */
+    inline bool round_scaled(double scaled, uint64_t& rounded)
+    {
+        double integral = floor(scaled);
+        double fraction = scaled - integral;
+        if (fabs(fraction - 0.5) < 1e-6)
+            return false;
+        rounded = uint64_t(integral) + (fraction > 0.5 ? 1 : 0);
+        return true;
+    }
+
+    /*
+     * writes `value` with `decimals` digits after decimal point,
+     * returns pointer after written text
+     */
+    char* write_decimal(char* out, bool negative, uint64_t value, int decimals)
+    {
+        char digits[32];
+        int length = 0;
+
+        do
+        {
+            digits[length++] = char('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (length <= decimals)
+            digits[length++] = '0';
+
+        if (negative)
+            *out++ = '-';
+        while (length != decimals)
+            *out++ = digits[--length];
+        if (decimals != 0)
+        {
+            *out++ = '.';
+            while (length != 0)
+                *out++ = digits[--length];
+        }
+        return out;
+    }
+}
+
+/* static */ size_t document_sink::format_fixed(
+                                                char* out,
+                                                double value,
+                                                int precision)
+{
+    double scaled = fabs(value) * powers_of_ten[precision < 0 || precision > 15 ? 0 : precision];
+    uint64_t rounded;
+
+    if (precision < 0 || precision > 15 || !(scaled < 1e15) ||
+        !round_scaled(scaled, rounded))
+        return snprintf(out, number_buffer_size, "%.*f", precision, value);
+
+    return write_decimal(out, signbit(value), rounded, precision) - out;
+}
+
+/* static */ size_t document_sink::format_general(
+                                                  char* out,
+                                                  double value)
+{
+    double absolute = fabs(value);
+
+    // fixed notation is used for exponents [-4, GENERAL_PRECISION),
+    // everything else (zero, scientific notation, nan, inf) is left to printf
+    if (!(absolute >= 1e-4 && absolute < 1e6))
+        return snprintf(out, number_buffer_size, "%g", value);
+
+    int exponent = int(floor(log10(absolute)));
+    int decimals = GENERAL_PRECISION - 1 - exponent;
+    double scaled = absolute * powers_of_ten[decimals];
+    uint64_t rounded;
+
+    // exponent computed by log10 has to be exact, rounding up
+    // to next power of ten would change it
+    if (decimals < 0 || decimals > 15 ||
+        !(scaled >= 1e5 && scaled < 999999.5) ||
+        !round_scaled(scaled, rounded))
+        return snprintf(out, number_buffer_size, "%g", value);
+
+    char* end = write_decimal(out, signbit(value), rounded, decimals);
+
+    // %g removes trailing zeros of fraction
+    if (decimals != 0)
+    {
+        while (end[-1] == '0')
+            --end;
+        if (end[-1] == '.')
+            --end;
+    }
+    return end - out;
+}
+
+document_sink& document_sink::operator<<(
+                                         const std::string& text)
+{
+    buffer.append(text);
+    return *this;
+}
+
+document_sink& document_sink::operator<<(
+                                         const char* text)
+{
+    buffer.append(text);
+    return *this;
+}
+
+document_sink& document_sink::operator<<(
+                                         char ch)
+{
+    buffer.push_back(ch);
+    return *this;
+}
+
+document_sink& document_sink::operator<<(
+                                         int value)
+{
+    char text[number_buffer_size];
+    bool negative = value < 0;
+    uint64_t absolute = negative ? -int64_t(value) : value;
+
+    buffer.append(text, write_decimal(text, negative, absolute, 0) - text);
+    return *this;
+}
+
+document_sink& document_sink::operator<<(
+                                         double value)
+{
+    char text[number_buffer_size];
+    buffer.append(text, format_general(text, value));
+    return *this;
+}
+
+void document_sink::append(
+                           const char* data,
+                           size_t size)
+{
+    buffer.append(data, size);
+}
+
+void document_sink::put_fixed(
+                              double value,
+                              int precision)
+{
+    char text[number_buffer_size];
+    buffer.append(text, format_fixed(text, value, precision));
+}
+
+void document_sink::pad(
+                        size_t from,
+                        size_t width)
+{
+    size_t length = buffer.size() - from;
+    if (length < width)
+        buffer.append(width - length, ' ');
+}
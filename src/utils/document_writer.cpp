@@ -19,11 +19,15 @@
  * USA.
  */
 
+#include <sys/stat.h>
+#include <zlib.h>
 
 #include "document_writer.hpp"
 #include "svg_writer.hpp"
 #include "ps_writer.hpp"
 #include "traveler_writer.hpp"
+#include "layout_writer.hpp"
+#include "spatial_index.hpp"
 
 using namespace std;
 
@@ -59,15 +63,26 @@ bool RGB::operator==(
 
 
 /* static */ image_writers document_writer::get_writers(
-                                                        bool use_colors)
+                                                        bool use_colors,
+                                                        bool use_compression,
+                                                        bool binary_layout)
 {
     image_writers vec;
     vec.emplace_back(new svg_writer());
     vec.emplace_back(new ps_writer());
     vec.emplace_back(new traveler_writer());
+    if (!use_colors)
+    {
+        vec.emplace_back(new layout_writer(layout_writer::json));
+        if (binary_layout)
+            vec.emplace_back(new layout_writer(layout_writer::binary));
+    }
     
     for (const auto& writer : vec)
+    {
         writer->use_colors(use_colors);
+        writer->use_compression(use_compression);
+    }
     
     return vec;
 }
@@ -77,40 +92,6 @@ bool RGB::operator==(
     return unique_ptr<document_writer>(new traveler_writer());
 }
 
-std::string document_writer::get_edge_formatted(
-                                                point from,
-                                                point to,
-                                                bool is_base_pair) const
-{
-    if (from.bad() || to.bad())
-    {
-        WARN("Cannot draw line between bad points");
-        return "";
-    }
-    if (is_base_pair)
-    {
-        point tmp = rna_tree::base_pair_edge_point(from, to);
-        to = rna_tree::base_pair_edge_point(to, from);
-        from = tmp;
-    }
-    
-    return get_line_formatted(from, to, RGB::BLACK);
-}
-
-bool rect_overlaps(const rectangle &r, const std::vector<point> &points ){
-    for (point p: points) {
-        if (r.has(p)) return true;
-    }
-    return false;
-}
-
-bool rect_overlaps(const rectangle &r, const std::vector<pair<point, point>> &lines ){
-    for (auto l: lines) {
-        if (r.intersects(l.first, l.second)) return true;
-    }
-    return false;
-}
-
 rectangle get_label_bb(point p, int number, float residue_distance){
     int cnt_digits = 0;
     while (number != 0) { number /= 10; cnt_digits++; }
@@ -122,8 +103,7 @@ rectangle get_label_bb(point p, int number, float residue_distance){
 }
 
 point sample_relevant_space(rectangle &r, point &p_start, point &dir, float grid_density,
-        const vector<point> &resiue_points,
-        const vector<pair<point, point>> &lines){
+        const spatial_index &index){
 
     point p_min = point(p_start.x, p_start.y), p_max = point(p_start.x, p_start.y);
     point dir_ortho = orthogonal(dir);
@@ -149,26 +129,23 @@ point sample_relevant_space(rectangle &r, point &p_start, point &dir, float grid
         } 
     }
 
+    // only residues and lines reaching into the sampled area are considered
     point r_dim = abs(r.get_bottom_right() - r.get_top_left());
-    vector<point> residue_points_in_grid;
     rectangle grid_rect = rectangle(p_min - r_dim, p_max + r_dim);
-    for (point p: resiue_points){
-        if (grid_rect.has(p)){
-            residue_points_in_grid.push_back(p);
-        }
-    }
-
-    vector<pair<point, point>> lines_in_grid;
-    for (auto l: lines){
-        if (grid_rect.has(l.first) || grid_rect.has(l.second)){
-            lines_in_grid.push_back(l);
-        }
-    }
-
+    auto in_grid_point =
+            [&grid_rect](const point& p)
+            {
+                return grid_rect.has(p);
+            };
+    auto in_grid_line =
+            [&grid_rect](const spatial_index::line& l)
+            {
+                return grid_rect.has(l.first) || grid_rect.has(l.second);
+            };
 
     for (point p: grid_points) {
         rectangle r_candidate = rectangle(p - r_dim/2, p + r_dim/2);
-        if (!rect_overlaps(r_candidate, residue_points_in_grid) && !rect_overlaps(r_candidate, lines_in_grid)) {
+        if (!index.any_point(r_candidate, in_grid_point) && !index.any_line(r_candidate, in_grid_line)) {
             return p;
         }
     }
@@ -200,21 +177,12 @@ point get_loop_center(rna_tree::iterator it) {
     return center / cnt;
 }
 
-std::string document_writer::get_numbering_formatted(
+numbering_label place_numbering_label(
         rna_tree::pre_post_order_iterator it,
         const int ix,
         const float residue_distance,
-        std::vector<point> pos_residues,
-        const std::vector<std::pair<point, point>> lines,
-        const numbering_def& numbering) const
+        const spatial_index& index)
 {
-    auto  found = std::find (numbering.positions.begin(), numbering.positions.end(), ix);
-    if (!(found != numbering.positions.end() || (ix > 0 && ix % numbering.interval == 0))){
-        return "";
-    }
-
-    ostringstream out;
-
     point v, p1;
     if (it->paired()){
         p1 = it->at(it.label_index()).p;
@@ -229,48 +197,17 @@ std::string document_writer::get_numbering_formatted(
 
     auto p = p1 + v * residue_distance * 3;
     rectangle bb = get_label_bb(p, ix, residue_distance);
-    if (rect_overlaps(bb, pos_residues) or rect_overlaps(bb, lines)) {
+    if (index.any_point(bb) or index.any_line(bb)) {
 //            p += normalize(v) * residue_distance * 3;
-        p = sample_relevant_space(bb, p, v, residue_distance, pos_residues, lines);
+        p = sample_relevant_space(bb, p, v, residue_distance, index);
         bb = get_label_bb(p, ix, residue_distance);
     }
 
-    rna_label l;
-    l.label = msprintf("%s", ix);
-    l.p = p;
-
-    out << get_label_formatted(l, "numbering-label", label_info());
-
     point p1_p = normalize(p - p1) ;
 //        float bb_width = abs(bb.get_bottom_right() - bb.get_top_left()).x;
     point isec = bb.intersection(p1, p);
-    out << get_line_formatted(p1 + p1_p * residue_distance/2, isec, "numbering-line");
-
-    return out.str();
-}
-
-std::string document_writer::get_label_formatted(
-                                                 rna_tree::pre_post_order_iterator it, label_info li) const
-{
-    if (!it->initiated_points())
-        return "";
-    
-    ostringstream out;
-    
-    out
-    << get_label_formatted(it->at(it.label_index()), get_default_color(it->status), li);
-    
-    if (it->paired() &&
-        it.preorder() &&
-        it->initiated_points() &&
-        !rna_tree::is_root(it))
-    {
-        out
-        << get_edge_formatted(it->at(0).p, it->at(1).p, true);
-    }
 
-    auto x = out.str();
-    return out.str();
+    return {ix, p, p1 + p1_p * residue_distance/2, isec};
 }
 
 const RGB& document_writer::get_default_color(
@@ -298,18 +235,77 @@ return COLOR_ ## rgb;
     }
 }
 
-void document_writer::print_to_stream(
-                                      const std::string& text)
+// sink is written to document after reaching this size
+#define SINK_FLUSH_SIZE     (1 << 16)
+
+document_writer::streampos document_writer::print(
+                                                  const std::string& text)
+{
+    streampos pos = streamoff(stats.bytes + sink.size());
+    
+    sink << text;
+    flush_sink(false);
+    
+    return pos;
+}
+
+void document_writer::print(
+                            const render_model& model)
+{
+    for (const render_model::element& e : model.elements)
+    {
+        switch (e.type)
+        {
+            case render_model::label:
+            case render_model::terminal:
+                format_label(sink, e.label, get_default_color(e.status), e.info);
+                break;
+            case render_model::base_pair:
+                format_line(sink, e.from, e.to, RGB::BLACK);
+                break;
+            case render_model::backbone:
+                format_line(sink, e.from, e.to, RGB::GRAY);
+                break;
+            case render_model::numbering:
+                format_label(sink, e.label, "numbering-label", label_info());
+                format_line(sink, e.from, e.to, "numbering-line");
+                break;
+            case render_model::circle:
+                format_circle(sink, e.from, e.radius);
+                break;
+        }
+        flush_sink(false);
+    }
+}
+
+void document_writer::flush_sink(
+                                 bool force)
 {
-    out << text;
-    validate_stream();
+    if (sink.size() == 0 || (!force && sink.size() < SINK_FLUSH_SIZE))
+        return;
+    
+    write_out(sink.data(), sink.size());
+    stats.bytes += sink.size();
+    sink.clear();
 }
 
-void document_writer::seek_from_current_pos(
-                                            off_type offset)
+void document_writer::write_out(
+                                const char* data,
+                                size_t size)
 {
-    out.seekp(offset, fstream::cur);
-    validate_stream();
+    if (memory_out != nullptr)
+        memory_out->append(data, size);
+    else if (compressed_out == nullptr)
+    {
+        out.write(data, size);
+        validate_stream();
+    }
+    else if (size != 0 && gzwrite(compressed_out, data, unsigned(size)) == 0)
+    {
+        int error;
+        throw io_exception("Writing compressed document %s failed: %s",
+                           stats.file, gzerror(compressed_out, &error));
+    }
 }
 
 void document_writer::validate_stream() const
@@ -318,6 +314,25 @@ void document_writer::validate_stream() const
         throw io_exception("Writing document failed");
 }
 
+/* static */ std::string document_writer::get_compressed_suffix(
+                                                               const std::string& suffix)
+{
+    // compressed svg has its own extension
+    if (suffix == ".svg")
+        return ".svgz";
+    return suffix + ".gz";
+}
+
+double document_writer::write_stats::get_ratio() const
+{
+    return stored == 0 ? 0 : double(bytes) / stored;
+}
+
+double document_writer::write_stats::get_throughput() const
+{
+    return seconds <= 0 ? 0 : bytes / seconds / (1024 * 1024);
+}
+
 vector<point> get_residues_positions(rna_tree &rna){
 
     vector<point> points;
@@ -347,153 +362,280 @@ vector<pair<point, point>> get_lines(rna_tree &rna){
     return lines;
 }
 
-std::string document_writer::get_rna_subtree_formatted(
-                                                       rna_tree &rna,
-                                                       const numbering_def& numbering) const
+/* static */ numbering_labels document_writer::get_numbering_labels(
+                                                                   rna_tree& rna,
+                                                                   const numbering_def& numbering)
 {
-    ostringstream out;
-    vector<point> residues_positions = get_residues_positions(rna);
-    vector<pair<point, point>> lines = get_lines(rna);
+    numbering_labels labels;
+    float residue_distance = rna.get_pairs_distance();
+    // residues and base pair lines are indexed once for all labels
+    spatial_index index(get_residues_positions(rna), get_lines(rna), 2 * residue_distance);
     int seq_ix = 0;
-    auto print =
-    [&rna, &out, &seq_ix, &residues_positions, &lines, &numbering, this](rna_tree::pre_post_order_iterator it)
+    auto place =
+    [&](rna_tree::pre_post_order_iterator it)
     {
-        out << get_numbering_formatted(it, seq_ix, rna.get_pairs_distance(), residues_positions, lines, numbering);
-        out << get_label_formatted(it, {seq_ix, it->at(it.label_index()).tmp_label, it->at(it.label_index()).tmp_ix});
+        auto found = std::find(numbering.positions.begin(), numbering.positions.end(), seq_ix);
+        if (found != numbering.positions.end() || (seq_ix > 0 && seq_ix % numbering.interval == 0))
+            labels.push_back(place_numbering_label(it, seq_ix, residue_distance, index));
         seq_ix++;
     };
-    
-    rna_tree::for_each_in_subtree(rna.begin_pre_post(), print);
-    
-    return out.str();
-}
 
-double document_writer::get_scaling_ratio() const{
-    return scaling_ratio;
+    rna_tree::for_each_in_subtree(rna.begin_pre_post(), place);
+
+    return labels;
 }
 
-void document_writer::set_scaling_ratio(rna_tree& rna){
-//    auto bp_dist = rna.get_pair_base_distance();
-//    scaling_ratio = 20 / bp_dist;
-        scaling_ratio = 1;
-};
+void render_model::add_circle(
+                              point centre,
+                              double radius)
+{
+    element e;
+    e.type = circle;
+    e.from = centre;
+    e.radius = radius;
+    elements.push_back(e);
+}
 
-std::string document_writer::get_rna_background_formatted(
-                                                          rna_tree::pre_post_order_iterator begin,
-                                                          rna_tree::pre_post_order_iterator end) const
+/* static */ render_model document_writer::get_render_model(
+                                                           rna_tree& rna,
+                                                           const numbering_labels& numbering)
 {
-    rna_tree::pre_post_order_iterator prev;
-    ostringstream out;
+    APP_DEBUG_FNAME;
+    
+    render_model model;
+    render_model::element e;
+    int seq_ix = 0;
+    int residues = 0;
+    // (element, residue) of paired residues waiting for their partner
+    vector<pair<size_t, int>> opened;
+    auto label = numbering.begin();
+    
+    auto add_line =
+    [&model, &e](render_model::element_type type, point from, point to)
+    {
+        e.type = type;
+        e.pair = -1;
+        e.from = from;
+        e.to = to;
+        model.elements.push_back(e);
+    };
+    
+    auto add =
+    [&](rna_tree::pre_post_order_iterator it)
+    {
+        if (label != numbering.end() && label->ix == seq_ix)
+        {
+            e.label = rna_label();
+            e.label.label = msprintf("%s", label->ix);
+            e.label.p = label->p;
+            add_line(render_model::numbering, label->line_from, label->line_to);
+            ++label;
+        }
+        
+        if (it->initiated_points())
+        {
+            const rna_label& l = it->at(it.label_index());
+            
+            e.label = l;
+            e.status = it->status;
+            e.info = label_info(seq_ix, l.tmp_label, l.tmp_ix);
+            e.pair = -1;
+            
+            if (rna_tree::is_root(it))
+                e.type = render_model::terminal;
+            else
+            {
+                e.type = render_model::label;
+                if (it->paired())
+                {
+                    // partner is visited in postorder, after whole subtree
+                    if (it.preorder())
+                        opened.emplace_back(model.elements.size(), residues);
+                    else if (!opened.empty())
+                    {
+                        e.pair = opened.back().second;
+                        model.elements[opened.back().first].pair = residues;
+                        opened.pop_back();
+                    }
+                }
+                ++residues;
+            }
+            model.elements.push_back(e);
+            
+            if (it->paired() &&
+                it.preorder() &&
+                !rna_tree::is_root(it))
+            {
+                point from = it->at(0).p;
+                point to = it->at(1).p;
+                
+                if (from.bad() || to.bad())
+                    WARN("Cannot draw line between bad points");
+                else
+                    add_line(render_model::base_pair,
+                             rna_tree::base_pair_edge_point(from, to),
+                             rna_tree::base_pair_edge_point(to, from));
+            }
+        }
+        seq_ix++;
+    };
+    
+    rna_tree::for_each_in_subtree(rna.begin_pre_post(), add);
     
-    while (++rna_tree::pre_post_order_iterator(begin) != end)
+    // backbone
+    rna_tree::pre_post_order_iterator prev, it = rna.begin_pre_post(), end = rna.end_pre_post();
+    while (++rna_tree::pre_post_order_iterator(it) != end)
     {
-        prev = begin++;
+        prev = it++;
         
         point p1 = prev->at(prev.label_index()).p;
-        point p2 = begin->at(begin.label_index()).p;
+        point p2 = it->at(it.label_index()).p;
         
         if (p1.bad() || p2.bad())
             continue;
-
+        
         point diff_orig = p2 - p1;
-
-        point tmp = rna_tree::base_pair_edge_point(p1, p2, get_scaling_ratio());
-        p2 = rna_tree::base_pair_edge_point(p2, p1, get_scaling_ratio());
+        
+        point tmp = rna_tree::base_pair_edge_point(p1, p2);
+        p2 = rna_tree::base_pair_edge_point(p2, p1);
         p1 = tmp;
-
+        
         point diff_edge = p2 - p1;
-
+        
         point diff = diff_orig * diff_edge;
-
+        
         //If the edge points cross, then the line should not be drawn at all
-        if (diff.x > 0 && diff.y > 0) out << get_line_formatted(p1, p2, RGB::GRAY);
+        if (diff.x > 0 && diff.y > 0)
+            add_line(render_model::backbone, p1, p2);
     }
     
-    return out.str();
+    return model;
+}
+
+double document_writer::get_scaling_ratio() const{
+    return scaling_ratio;
 }
 
-std::string document_writer::get_rna_formatted(
-                                               rna_tree rna,
-                                               const numbering_def& numbering) const
+void document_writer::set_scaling_ratio(rna_tree& rna){
+//    auto bp_dist = rna.get_pair_base_distance();
+//    scaling_ratio = 20 / bp_dist;
+        scaling_ratio = 1;
+};
+
+document_writer::~document_writer()
 {
-    return get_rna_subtree_formatted(rna, numbering)
-    + get_rna_background_formatted(rna.begin_pre_post(), rna.end_pre_post());
+    if (memory_opened)
+    {
+        memory_out->append(sink.data(), sink.size());
+        memory_out->append(footer);
+    }
+    else if (compressed_out != nullptr)
+    {
+        sink << footer;
+        gzwrite(compressed_out, sink.data(), unsigned(sink.size()));
+        gzclose(compressed_out);
+    }
+    else if (out.is_open())
+    {
+        out.write(sink.data(), sink.size());
+        out << footer;
+        out.close();
+    }
 }
 
 void document_writer::init(
                            const std::string& filename,
-                           const std::string& suffix)
+                           const std::string& suffix,
+                           const std::string& _footer)
 {
     APP_DEBUG_FNAME;
     assert(!filename.empty());
     
-    string file = filename + suffix;
+    bool compress = compressed && memory_out == nullptr;
+    string file = filename + (compress ? get_compressed_suffix(suffix) : suffix);
     INFO("Opening document %s for writing RNA", file);
     
     out.close();
+    if (compressed_out != nullptr)
+    {
+        gzclose(compressed_out);
+        compressed_out = nullptr;
+    }
+    memory_opened = false;
     
-    // create file & truncate
-    out.open(file, ios::out);
-    out.close();
-    
-    // open in normal mode
-    out.open(file, ios::out | ios::in);
-    out
-    << std::unitbuf
-    << std::scientific;
+    if (memory_out != nullptr)
+        memory_opened = true;
+    else if (compress)
+    {
+        // document is compressed as it is written, gzip buffer
+        // is as large as the sink, so it is compressed in one pass
+        compressed_out = gzopen(file.c_str(), "wb");
+        if (compressed_out == nullptr)
+            throw io_exception("Cannot open output file %s for writing.", file);
+        gzbuffer(compressed_out, SINK_FLUSH_SIZE);
+    }
+    else
+    {
+        out.open(file, ios::out | ios::trunc);
+        
+        if (!out.good())
+            throw io_exception("Cannot open output file %s for writing.", filename);
+    }
     
-    if (!out.good())
-        throw io_exception("Cannot open output file %s for writing.", filename);
-    assert(out.good());
+    footer = _footer;
+    stats = write_stats();
+    stats.file = file;
+    opened = chrono::steady_clock::now();
+    sink.clear();
 }
 
-void document_writer::seek(
-                           streampos pos)
+void document_writer::close()
 {
-    out.seekp(pos);
+    if (!out.is_open() && compressed_out == nullptr && !memory_opened)
+        return;
     
-    assert(out.good());
-}
-
-void document_writer::seek_end()
-{
-    out.seekp(0, out.end);
+    sink << footer;
+    flush_sink(true);
+    if (memory_opened)
+    {
+        memory_opened = false;
+        stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - opened).count();
+        stats.stored = stats.bytes;
+        return;
+    }
+    if (compressed_out != nullptr)
+    {
+        int result = gzclose(compressed_out);
+        compressed_out = nullptr;
+        if (result != Z_OK)
+            throw io_exception("Writing compressed document %s failed", stats.file);
+    }
+    else
+    {
+        out.flush();
+        validate_stream();
+        out.close();
+    }
     
-    assert(out.good());
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - opened).count();
+    struct stat info;
+    stats.stored = stat(stats.file.c_str(), &info) == 0 ? size_t(info.st_size) : 0;
 }
 
-streampos document_writer::get_pos()
+void document_writer::use_colors(
+                                 bool _colored)
 {
-    streampos pos = out.tellp();
-    assert(pos != -1);
-    
-    return pos;
+    colored = _colored;
 }
 
-size_t document_writer::fill(
-                             char ch)
+void document_writer::use_compression(
+                                      bool _compressed)
 {
-    streampos pos, end;
-    
-    pos = get_pos();
-    seek_end();
-    end = get_pos();
-    
-    size_t n = end - pos;
-    
-    if (n != 0)
-    {
-        seek(pos);
-        out
-        << string(n - 1, ch)
-        << endl;
-    }
-    seek(pos);
-    return n;
+    compressed = _compressed;
 }
 
-void document_writer::use_colors(
-                                 bool _colored)
+void document_writer::use_memory(
+                                 std::string* document)
 {
-    colored = _colored;
+    memory_out = document;
 }
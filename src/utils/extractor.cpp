@@ -27,6 +27,7 @@
 #include "crw_extractor.hpp"
 #include "varna_extractor.hpp"
 #include "traveler_extractor.hpp"
+#include "layout_extractor.hpp"
 #include "types.hpp"
 #include "utils.hpp"
 
@@ -51,7 +52,7 @@ struct regex_exception : public my_exception
 /* static */ std::vector<extractor_ptr> extractor::get_all_extractors()
 {
     std::vector<extractor_ptr> extractors;
-    for (extractor* e : std::vector<extractor*>({new crw_extractor(), new varna_extractor(), new traveler_extractor()}))
+    for (extractor* e : std::vector<extractor*>({new crw_extractor(), new varna_extractor(), new traveler_extractor(), new layout_extractor()}))
         extractors.push_back(extractor_ptr(e));
     return extractors;
 }
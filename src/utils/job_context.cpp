@@ -0,0 +1,72 @@
+/*
+ * File: job_context.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <atomic>
+
+#include "job_context.hpp"
+
+using namespace std;
+
+namespace
+{
+    thread_local job_context* entered = nullptr;
+
+    // ids of trees and nodes created outside of any context
+    atomic<size_t> global_tree_ids(0);
+    atomic<size_t> global_node_ids(0);
+}
+
+job_context::scope::scope(
+                          job_context& context)
+    : previous(entered)
+{
+    entered = &context;
+}
+
+job_context::scope::~scope()
+{
+    entered = previous;
+}
+
+job_context::job_context(
+                         const std::string& name)
+    : _name(name)
+{ }
+
+/* static */ job_context* job_context::current()
+{
+    return entered;
+}
+
+/* static */ size_t job_context::next_tree_id()
+{
+    if (entered != nullptr)
+        return entered->tree_ids++;
+    return global_tree_ids++;
+}
+
+/* static */ size_t job_context::next_node_id()
+{
+    if (entered != nullptr)
+        return entered->node_ids++;
+    return global_node_ids++;
+}
@@ -0,0 +1,300 @@
+/*
+ * File: layout_extractor.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "layout_extractor.hpp"
+#include "layout_writer.hpp"
+#include "types.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+namespace
+{
+    /*
+     * minimal reader of json layout, values of keys which are not
+     * needed are skipped without validation
+     */
+    class json_reader
+    {
+    public:
+        json_reader(const char* _begin, const char* _end)
+        : begin(_begin), p(_begin), end(_end)
+        { }
+
+        void expect(char ch)
+        {
+            skip_spaces();
+            if (p == end || *p != ch)
+                throw illegal_state_exception("Layout: '%s' expected at offset %s", ch, offset());
+            ++p;
+        }
+
+        /*
+         * consumes `ch` if it is next character
+         */
+        bool accept(char ch)
+        {
+            skip_spaces();
+            if (p != end && *p == ch)
+            {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+
+        string read_string()
+        {
+            string text;
+            expect('"');
+            while (p != end && *p != '"')
+            {
+                if (*p == '\\' && ++p != end)
+                {
+                    switch (*p)
+                    {
+                        case 'u':
+                            text.push_back(char(strtol(string(p + 1, min<size_t>(4, end - p - 1)).c_str(), nullptr, 16)));
+                            p += min<size_t>(4, end - p - 1);
+                            break;
+                        case 'n':
+                            text.push_back('\n');
+                            break;
+                        case 't':
+                            text.push_back('\t');
+                            break;
+                        default:
+                            text.push_back(*p);
+                            break;
+                    }
+                }
+                else
+                    text.push_back(*p);
+                ++p;
+            }
+            expect('"');
+            return text;
+        }
+
+        double read_number()
+        {
+            skip_spaces();
+            // writer stores inf and nan as null
+            if (end - p >= 4 && memcmp(p, "null", 4) == 0)
+            {
+                p += 4;
+                return NAN;
+            }
+
+            // numbers are short, strtod needs null-terminated copy
+            char buffer[64];
+            size_t length = 0;
+            while (p != end && length + 1 < sizeof(buffer) &&
+                   (isdigit(*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+                buffer[length++] = *p++;
+            buffer[length] = '\0';
+
+            char* number_end;
+            double value = strtod(buffer, &number_end);
+            if (length == 0 || number_end != buffer + length)
+                throw illegal_state_exception("Layout: number expected at offset %s", offset());
+            return value;
+        }
+
+        vector<double> read_numbers()
+        {
+            vector<double> values;
+            expect('[');
+            if (accept(']'))
+                return values;
+            do
+                values.push_back(read_number());
+            while (accept(','));
+            expect(']');
+            return values;
+        }
+
+        void skip_value()
+        {
+            skip_spaces();
+            if (p == end)
+                return;
+            if (*p == '"')
+            {
+                read_string();
+                return;
+            }
+            if (*p != '[' && *p != '{')
+            {
+                while (p != end && *p != ',' && *p != '}' && *p != ']')
+                    ++p;
+                return;
+            }
+
+            int depth = 0;
+            for (; p != end; ++p)
+            {
+                if (*p == '"')
+                {
+                    read_string();
+                    --p;
+                }
+                else if (*p == '[' || *p == '{')
+                    ++depth;
+                else if ((*p == ']' || *p == '}') && --depth == 0)
+                {
+                    ++p;
+                    return;
+                }
+            }
+        }
+
+    private:
+        void skip_spaces()
+        {
+            while (p != end && isspace(*p))
+                ++p;
+        }
+
+        size_t offset() const
+        {
+            return p - begin;
+        }
+
+    private:
+        const char* begin;
+        const char* p;
+        const char* end;
+    };
+
+    uint32_t get_uint32(const char*& p, const char* end)
+    {
+        if (end - p < 4)
+            throw illegal_state_exception("Layout: unexpected end of binary document");
+
+        uint32_t value = 0;
+        for (size_t i = 0; i < 4; ++i)
+            value |= uint32_t(static_cast<unsigned char>(p[i])) << (8 * i);
+        p += 4;
+        return value;
+    }
+
+    double get_float64(const char*& p, const char* end)
+    {
+        if (end - p < 8)
+            throw illegal_state_exception("Layout: unexpected end of binary document");
+
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 8; ++i)
+            bits |= uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+        p += 8;
+
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+void layout_extractor::extract(
+                               const string& filename)
+{
+    points.clear();
+    labels.clear();
+
+    mapped_file file(filename);
+
+    if (file.size() >= LAYOUT_BINARY_MAGIC_SIZE &&
+        memcmp(file.begin(), LAYOUT_BINARY_MAGIC, LAYOUT_BINARY_MAGIC_SIZE) == 0)
+        extract_binary(file.begin(), file.end());
+    else
+        extract_json(file.begin(), file.end());
+
+    // layout is stored in the internal coordinates, so unlike
+    // in other extractors y axis is not mirrored
+}
+
+void layout_extractor::extract_json(
+                                    const char* begin,
+                                    const char* end)
+{
+    json_reader json(begin, end);
+    vector<double> x, y;
+
+    json.expect('{');
+    if (!json.accept('}'))
+    {
+        do
+        {
+            string key = json.read_string();
+            json.expect(':');
+            if (key == "x")
+                x = json.read_numbers();
+            else if (key == "y")
+                y = json.read_numbers();
+            else if (key == "base")
+                labels = json.read_string();
+            else
+                json.skip_value();
+        } while (json.accept(','));
+        json.expect('}');
+    }
+
+    if (x.size() != labels.size() || y.size() != labels.size())
+        throw illegal_state_exception("Layout: columns x, y and base have different sizes");
+
+    points.reserve(labels.size());
+    for (size_t i = 0; i < labels.size(); ++i)
+        points.push_back(point(x[i], y[i]));
+}
+
+void layout_extractor::extract_binary(
+                                      const char* begin,
+                                      const char* end)
+{
+    const char* p = begin + LAYOUT_BINARY_MAGIC_SIZE;
+
+    uint32_t version = get_uint32(p, end);
+    if (version != LAYOUT_BINARY_VERSION)
+        throw illegal_state_exception("Layout: unsupported binary version %s", version);
+
+    uint32_t residues = get_uint32(p, end);
+    uint32_t name_length = get_uint32(p, end);
+    // x, y, base, pair and template columns follow the name
+    if (size_t(end - p) < name_length ||
+        (size_t(end - p) - name_length) / (8 + 8 + 1 + 4 + 4) < residues)
+        throw illegal_state_exception("Layout: unexpected end of binary document");
+    p += name_length;
+
+    points.resize(residues);
+    for (point& pt : points)
+        pt.x = get_float64(p, end);
+    for (point& pt : points)
+        pt.y = get_float64(p, end);
+    labels.assign(p, p + residues);
+}
@@ -0,0 +1,213 @@
+/*
+ * File: layout_writer.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "layout_writer.hpp"
+
+using namespace std;
+
+namespace
+{
+    void put_uint32(document_sink& out, uint32_t value)
+    {
+        char bytes[4];
+        for (size_t i = 0; i < sizeof(bytes); ++i)
+            bytes[i] = char((value >> (8 * i)) & 0xff);
+        out.append(bytes, sizeof(bytes));
+    }
+
+    void put_float64(document_sink& out, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        char bytes[8];
+        for (size_t i = 0; i < sizeof(bytes); ++i)
+            bytes[i] = char((bits >> (8 * i)) & 0xff);
+        out.append(bytes, sizeof(bytes));
+    }
+
+    void put_json_string(document_sink& out, const string& text)
+    {
+        static const char hex[] = "0123456789abcdef";
+
+        out << '"';
+        for (char ch : text)
+        {
+            if (ch == '"' || ch == '\\')
+                out << '\\' << ch;
+            else if (static_cast<unsigned char>(ch) < 0x20)
+                out << "\\u00" << hex[ch >> 4] << hex[ch & 0xf];
+            else
+                out << ch;
+        }
+        out << '"';
+    }
+
+    /*
+     * shortest %g text which is read back as the same double;
+     * json has no inf and nan, they are written as null
+     */
+    void put_json_number(document_sink& out, double value)
+    {
+        if (!isfinite(value))
+        {
+            out << "null";
+            return;
+        }
+
+        char text[32];
+        int length = 0;
+        for (int precision = 15; precision <= 17; ++precision)
+        {
+            length = snprintf(text, sizeof(text), "%.*g", precision, value);
+            if (strtod(text, nullptr) == value)
+                break;
+        }
+        out.append(text, length);
+    }
+
+    void put_json_number(document_sink& out, int value)
+    {
+        out << value;
+    }
+
+    template <typename T>
+    void put_json_array(document_sink& out, const char* key, const vector<T>& values)
+    {
+        out << ",\"" << key << "\":[";
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (i != 0)
+                out << ',';
+            put_json_number(out, values[i]);
+        }
+        out << ']';
+    }
+}
+
+struct layout_writer::columns
+{
+    vector<double> x;
+    vector<double> y;
+    string bases;
+    vector<int> pairs;
+    vector<int> templates;
+};
+
+layout_writer::layout_writer(
+                             format_type _format)
+    : format(_format)
+{ }
+
+void layout_writer::init(
+                         const std::string& filename,
+                         rna_tree& rna)
+{
+    document_writer::init(filename, format == binary ? ".layout" : ".json");
+    name = rna.name();
+}
+
+void layout_writer::print(
+                          const render_model& model)
+{
+    columns c;
+    for (const render_model::element& e : model.elements)
+    {
+        if (e.type != render_model::label)
+            continue;
+
+        c.x.push_back(e.label.p.x);
+        c.y.push_back(e.label.p.y);
+        c.bases.push_back(e.label.label.empty() ? ' ' : e.label.label[0]);
+        c.pairs.push_back(e.pair);
+        c.templates.push_back(max(e.info.tmp_ix, 0));
+    }
+
+    if (format == binary)
+        format_binary(get_sink(), c);
+    else
+        format_json(get_sink(), c);
+}
+
+void layout_writer::format_json(
+                                document_sink& out,
+                                const columns& c) const
+{
+    out << "{\"name\":";
+    put_json_string(out, name);
+    out << ",\"residues\":" << int(c.bases.size());
+    put_json_array(out, "x", c.x);
+    put_json_array(out, "y", c.y);
+    out << ",\"base\":";
+    put_json_string(out, c.bases);
+    put_json_array(out, "pair", c.pairs);
+    put_json_array(out, "template", c.templates);
+    out << "}\n";
+}
+
+void layout_writer::format_binary(
+                                  document_sink& out,
+                                  const columns& c) const
+{
+    out.append(LAYOUT_BINARY_MAGIC, LAYOUT_BINARY_MAGIC_SIZE);
+    put_uint32(out, LAYOUT_BINARY_VERSION);
+    put_uint32(out, uint32_t(c.bases.size()));
+    put_uint32(out, uint32_t(name.size()));
+    out << name;
+
+    for (double x : c.x)
+        put_float64(out, x);
+    for (double y : c.y)
+        put_float64(out, y);
+    out << c.bases;
+    for (int pair : c.pairs)
+        put_uint32(out, uint32_t(pair));
+    for (int ix : c.templates)
+        put_uint32(out, uint32_t(ix));
+}
+
+void layout_writer::format_circle(document_sink&, point, double) const
+{
+}
+
+void layout_writer::format_label(document_sink&, const rna_label&, const RGB&, const label_info&) const
+{
+}
+
+void layout_writer::format_label(document_sink&, const rna_label&, const std::string&, const label_info&) const
+{
+}
+
+void layout_writer::format_line(document_sink&, point, point, const RGB&) const
+{
+}
+
+void layout_writer::format_line(document_sink&, point, point, const std::string&) const
+{
+}
@@ -20,9 +20,14 @@
  */
 
 
-#include <iomanip>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
 //#include <unistd.h>
 
+#include "job_context.hpp"
 #include "logger.hpp"
 #include "types.hpp"
 #include "mprintf.hpp"
@@ -30,6 +35,68 @@
 
 using namespace std;
 
+
+struct logger::async_writer
+{
+    mutex lock;
+    // message queued or writer stopping
+    condition_variable queued;
+    // queue has space or everything was written
+    condition_variable written;
+    thread worker;
+    
+    vector<string> queue = vector<string>(LOGGER_QUEUE_SIZE);
+    size_t first = 0;
+    size_t count = 0;
+    // messages taken from queue, which are being written
+    size_t writing = 0;
+    bool stopping = false;
+    bool failed = false;
+    
+    /**
+     * writes queued messages to `out` until stopped, streams are
+     * flushed once queue is empty
+     */
+    void run(
+             const std::vector<FILE*>& out)
+    {
+        vector<string> batch;
+        unique_lock<mutex> l(lock);
+        
+        while (true)
+        {
+            queued.wait(l, [this]() { return count != 0 || stopping; });
+            if (count == 0)
+                return;
+            
+            batch.clear();
+            for (; count != 0; --count)
+            {
+                batch.push_back(move(queue[first]));
+                first = (first + 1) % queue.size();
+            }
+            writing = batch.size();
+            written.notify_all();
+            l.unlock();
+            
+            bool error = false;
+            for (FILE* f : out)
+            {
+                for (const string& text : batch)
+                    fwrite(text.data(), 1, text.size(), f);
+                fflush(f);
+                error = error || ferror(f);
+            }
+            
+            l.lock();
+            failed = failed || error;
+            writing = 0;
+            written.notify_all();
+        }
+    }
+};
+
+
 #ifndef NO_LOGGING
 
 #ifndef LOG_FILE
@@ -69,10 +136,22 @@ logger::logger(
         throw io_exception("Cannot open log file %s", filename);
     
     out.push_back(f);
+    writer.reset(new async_writer());
 }
 
 logger::~logger()
 {
+    if (writer)
+    {
+        {
+            lock_guard<mutex> l(writer->lock);
+            writer->stopping = true;
+        }
+        writer->queued.notify_all();
+        if (writer->worker.joinable())
+            writer->worker.join();
+    }
+    
     for (FILE* f : out)
         if (!contains({stdout, stderr}, f))
             fclose(f);
@@ -80,63 +159,80 @@ logger::~logger()
 
 void logger::log(
                  priority p,
-                 const std::string& text)
+                 std::string text)
 {
-    if (!can_log(p))
+    if (!can_log(p) || !writer)
         return;
     
-    for (FILE* f : out)
     {
-        fprintf(f, "%s", text.c_str());
-        fflush(f);
+        unique_lock<mutex> l(writer->lock);
+        // writer thread is started with the first message
+        if (!writer->worker.joinable())
+            writer->worker = thread(&async_writer::run, writer.get(), out);
+        
+        writer->written.wait(l, [this]() { return writer->count != writer->queue.size(); });
+        writer->queue[(writer->first + writer->count) % writer->queue.size()] = move(text);
+        ++writer->count;
     }
+    writer->queued.notify_one();
+    
+    if (p >= ERROR)
+        flush();
     check_errors();
 }
 
+void logger::flush()
+{
+    if (!writer)
+        return;
+    
+    unique_lock<mutex> l(writer->lock);
+    writer->written.wait(l, [this]() { return writer->count == 0 && writer->writing == 0; });
+}
+
 /* static */ string logger::message_header(
                                            priority p)
 {
-    size_t hour, minute, second, millisecond;
-    timespec cputime, clocks;
-    std::ostringstream stream;
+    static const char* names[] = {"[TRACE]", "[DEBUG]", "[INFO]", "[WARN]", "[ERROR]", "[EMERG]"};
+    // local time is converted once a second per thread
+    thread_local time_t cached_second = -1;
+    thread_local tm cached;
+    timespec clocks;
+    char header[64];
     
-    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cputime);
     clock_gettime(CLOCK_REALTIME, &clocks);
-    tm c = *localtime(&clocks.tv_sec);
-    
-    hour = c.tm_hour;
-    minute = c.tm_min;
-    second = c.tm_sec;
-    millisecond = clocks.tv_nsec / 1000000LL;
+    if (clocks.tv_sec != cached_second)
+    {
+        localtime_r(&clocks.tv_sec, &cached);
+        cached_second = clocks.tv_sec;
+    }
     
     // PATTERN:
-    //  21:28 [%PRIORITY%] %MESSAGE%
+    //  21:28:03:123 [%PRIORITY%] %MESSAGE%
+    //  21:28:03:123 [%PRIORITY%] [%JOB%] %MESSAGE%   (in job_context)
     //
-    stream
-    << setfill('0') << setw(2)
-    << hour
-    << ':'
-    << setfill('0') << setw(2)
-    << minute
-    << ':'
-    << setfill('0') << setw(2)
-    << second
-    << ':'
-    << setfill('0') << setw(3)
-    << millisecond
-    << ' '
-    << setfill(' ') << setw(8) << left
-    << ("[" + to_string(p) + "]");
+    snprintf(header, sizeof(header), "%02d:%02d:%02d:%03d %-8s",
+             cached.tm_hour, cached.tm_min, cached.tm_sec,
+             int(clocks.tv_nsec / 1000000LL), names[size_t(p) < 6 ? p : EMERG]);
+    
+    // messages of concurrent jobs are told apart by job name
+    const job_context* context = job_context::current();
+    if (context != nullptr && !context->name().empty())
+        return header + ("[" + context->name() + "] ");
     
-    return stream.str();
+    return header;
 }
 
 void logger::check_errors()
 {
-    for (FILE* f : out)
+    if (!writer)
+        return;
+    
+    lock_guard<mutex> l(writer->lock);
+    if (writer->failed)
     {
-        if (ferror(f))
-            throw io_exception("Error occured while printing log messages");
+        writer->failed = false;
+        throw io_exception("Error occured while printing log messages");
     }
 }
 
@@ -173,8 +269,8 @@ void logger::logger_stream::flush()
 {
     if (!l.can_log(p))
         return;
-    l.log(p, message_header(p));
-    l.log(p, stream.str());
+    // header and text are one message, so messages do not interleave
+    l.log(p, message_header(p) + stream.str());
     stream.str("");
 }
 
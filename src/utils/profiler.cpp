@@ -0,0 +1,398 @@
+/*
+ * File: profiler.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+
+#include <sys/resource.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "profiler.hpp"
+#include "types.hpp"
+
+using namespace std;
+
+namespace
+{
+    // trivial thread locals need no initialization, so they
+    // can be used by operator new itself, see count_allocation
+    thread_local size_t thread_allocations = 0;
+    thread_local size_t thread_allocated_bytes = 0;
+
+    atomic<bool> enabled(false);
+    mutex stages_mutex;
+    vector<profiler::stage> stages;
+    chrono::steady_clock::time_point started;
+    double started_cpu = 0;
+
+    double get_cpu_time(
+                        clockid_t clock)
+    {
+        timespec t;
+        if (clock_gettime(clock, &t) != 0)
+            return 0;
+        return t.tv_sec + t.tv_nsec / 1e9;
+    }
+
+    atomic<bool> counting(false);
+    // bit of every event which could be opened
+    atomic<unsigned> counted(0);
+    // why no event is counted
+    string counters_error;
+
+    /**
+     * hardware events of one thread read together as a group,
+     * events which can not be opened are left out
+     */
+    class perf_group
+    {
+    public:
+        perf_group()
+        {
+#ifdef __linux__
+            static const uint64_t events[profiler::counters_count] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                // usually last level cache misses
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES,
+            };
+
+            for (size_t c = 0; c < profiler::counters_count; ++c)
+            {
+                perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = events[c];
+                // user space only is permitted with perf_event_paranoid 2
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP |
+                    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                // calling thread on any cpu, first opened event leads the group
+                int fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC));
+                if (fd < 0)
+                {
+                    error = strerror(errno);
+                    continue;
+                }
+                if (leader < 0)
+                    leader = fd;
+                fds[c] = fd;
+                index[c] = int(members++);
+            }
+#else
+            error = "perf events are supported only on Linux";
+#endif
+        }
+
+        ~perf_group()
+        {
+#ifdef __linux__
+            for (int fd : fds)
+                if (fd >= 0)
+                    close(fd);
+#endif
+        }
+
+        void read_values(
+                         profiler::counter_sample& sample) const
+        {
+            sample = profiler::counter_sample();
+#ifdef __linux__
+            // number of events, time enabled, time running, values
+            uint64_t data[3 + profiler::counters_count];
+            if (leader < 0 ||
+                read(leader, data, sizeof(uint64_t) * (3 + members)) < ssize_t(sizeof(uint64_t) * (3 + members)))
+                return;
+
+            sample.enabled = data[1];
+            sample.running = data[2];
+            for (size_t c = 0; c < profiler::counters_count; ++c)
+                if (fds[c] >= 0)
+                    sample.values[c] = data[3 + index[c]];
+#endif
+        }
+
+        unsigned get_opened() const
+        {
+            unsigned opened = 0;
+            for (size_t c = 0; c < profiler::counters_count; ++c)
+                if (fds[c] >= 0)
+                    opened |= 1u << c;
+            return opened;
+        }
+
+    public:
+        string error;
+
+    private:
+        int leader = -1;
+        int fds[profiler::counters_count] = {-1, -1, -1, -1};
+        int index[profiler::counters_count] = {};
+        size_t members = 0;
+    };
+
+    /**
+     * group of calling thread, opened by first stage of the thread
+     */
+    perf_group& get_thread_group()
+    {
+        thread_local perf_group group;
+        return group;
+    }
+}
+
+/* static */ void profiler::enable()
+{
+    lock_guard<mutex> lock(stages_mutex);
+    started = chrono::steady_clock::now();
+    started_cpu = get_cpu_time(CLOCK_PROCESS_CPUTIME_ID);
+    enabled = true;
+}
+
+/* static */ void profiler::disable()
+{
+    enabled = false;
+}
+
+/* static */ bool profiler::is_enabled()
+{
+    return enabled;
+}
+
+/* static */ bool profiler::enable_counters()
+{
+    perf_group& group = get_thread_group();
+    lock_guard<mutex> lock(stages_mutex);
+
+    counted = group.get_opened();
+    counters_error = counted == 0 ? group.error : "";
+    counting = counted != 0;
+    return counting;
+}
+
+/* static */ bool profiler::is_counting()
+{
+    return counting;
+}
+
+/* static */ bool profiler::is_counted(
+                                       counter c)
+{
+    return (counted & (1u << c)) != 0;
+}
+
+/* static */ const char* profiler::get_counter_name(
+                                                    counter c)
+{
+    static const char* names[] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+    return names[c];
+}
+
+/* static */ void profiler::clear()
+{
+    lock_guard<mutex> lock(stages_mutex);
+    stages.clear();
+}
+
+/* static */ void profiler::add(
+                                const stage& s)
+{
+    lock_guard<mutex> lock(stages_mutex);
+
+    for (stage& actual : stages)
+        if (actual.name == s.name)
+        {
+            actual.calls += s.calls;
+            actual.wall += s.wall;
+            actual.cpu += s.cpu;
+            actual.allocations += s.allocations;
+            actual.allocated_bytes += s.allocated_bytes;
+            actual.peak_rss = max(actual.peak_rss, s.peak_rss);
+            for (size_t c = 0; c < counters_count; ++c)
+                actual.counters[c] += s.counters[c];
+            return;
+        }
+    stages.push_back(s);
+}
+
+/* static */ std::vector<profiler::stage> profiler::get_stages()
+{
+    lock_guard<mutex> lock(stages_mutex);
+    return stages;
+}
+
+/* static */ std::string profiler::to_json()
+{
+    vector<stage> recorded = get_stages();
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    double cpu = get_cpu_time(CLOCK_PROCESS_CPUTIME_ID) - started_cpu;
+
+    string json = msprintf("{\n  \"wall\": %s,\n  \"cpu\": %s,\n  \"peak_rss_kb\": %s,\n",
+                           wall, cpu, get_peak_rss());
+
+    // counted events are listed, or reason why none is counted
+    vector<counter> events;
+    {
+        lock_guard<mutex> lock(stages_mutex);
+        for (size_t c = 0; c < counters_count; ++c)
+            if (counting && is_counted(counter(c)))
+                events.push_back(counter(c));
+        if (!counters_error.empty())
+            json += msprintf("  \"counters\": [],\n  \"counters_error\": \"%s\",\n", counters_error);
+    }
+    if (!events.empty())
+    {
+        json += "  \"counters\": [";
+        for (size_t i = 0; i < events.size(); ++i)
+            json += msprintf("%s\"%s\"", i == 0 ? "" : ", ", get_counter_name(events[i]));
+        json += "],\n";
+    }
+
+    json += "  \"stages\": [";
+    for (size_t i = 0; i < recorded.size(); ++i)
+    {
+        const stage& s = recorded[i];
+        json += msprintf("%s\n    {\"name\": \"%s\", \"calls\": %s, \"wall\": %s, \"cpu\": %s, "
+                         "\"allocations\": %s, \"allocated_bytes\": %s, \"peak_rss_kb\": %s",
+                         i == 0 ? "" : ",", s.name, s.calls, s.wall, s.cpu,
+                         s.allocations, s.allocated_bytes, s.peak_rss);
+        for (counter c : events)
+            json += msprintf(", \"%s\": %s", get_counter_name(c), s.counters[c]);
+        json += "}";
+    }
+    json += "\n  ]\n}\n";
+
+    return json;
+}
+
+/* static */ void profiler::save(
+                                 const std::string& filename)
+{
+    ofstream out(filename);
+    out << to_json();
+    if (!out)
+        throw io_exception("Writing profile %s failed", filename);
+}
+
+/* static */ void profiler::count_allocation(
+                                             size_t size)
+{
+    ++thread_allocations;
+    thread_allocated_bytes += size;
+}
+
+/* static */ size_t profiler::get_allocations()
+{
+    return thread_allocations;
+}
+
+/* static */ size_t profiler::get_allocated_bytes()
+{
+    return thread_allocated_bytes;
+}
+
+/* static */ double profiler::get_thread_cpu_time()
+{
+    return get_cpu_time(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/* static */ void profiler::get_thread_counters(
+                                                counter_sample& sample)
+{
+    get_thread_group().read_values(sample);
+}
+
+/* static */ void profiler::get_counters_delta(
+                                              const counter_sample& from,
+                                              const counter_sample& to,
+                                              counter_values& delta)
+{
+    for (uint64_t& v : delta)
+        v = 0;
+    // nothing was counted or reading failed
+    if (to.running <= from.running || to.enabled < from.enabled)
+        return;
+
+    // events sharing hardware counters are extrapolated by the part
+    // of this interval they were counted, not of the whole run
+    double scale = double(to.enabled - from.enabled) / (to.running - from.running);
+    for (size_t c = 0; c < counters_count; ++c)
+        delta[c] = uint64_t((to.values[c] - from.values[c]) * scale);
+}
+
+/* static */ long profiler::get_peak_rss()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;
+}
+
+
+profile_scope::profile_scope(
+                             const char* name)
+    : active(profiler::is_enabled())
+{
+    if (!active)
+        return;
+
+    value.name = name;
+    value.calls = 1;
+    wall = chrono::steady_clock::now();
+    cpu = profiler::get_thread_cpu_time();
+    allocations = profiler::get_allocations();
+    allocated_bytes = profiler::get_allocated_bytes();
+    if (profiler::is_counting())
+        profiler::get_thread_counters(counters);
+}
+
+profile_scope::~profile_scope()
+{
+    if (!active)
+        return;
+
+    value.wall = chrono::duration<double>(chrono::steady_clock::now() - wall).count();
+    value.cpu = profiler::get_thread_cpu_time() - cpu;
+    value.allocations = profiler::get_allocations() - allocations;
+    value.allocated_bytes = profiler::get_allocated_bytes() - allocated_bytes;
+    value.peak_rss = profiler::get_peak_rss();
+    if (profiler::is_counting())
+    {
+        profiler::counter_sample now;
+        profiler::get_thread_counters(now);
+        profiler::get_counters_delta(counters, now, value.counters);
+    }
+    profiler::add(value);
+}
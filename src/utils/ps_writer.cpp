@@ -20,13 +20,10 @@
  */
 
 
-#include <iomanip>
-
 #include "ps_writer.hpp"
 
 #define PS_COLUMNS_WIDTH        15
 #define PS_END_STRING           "showpage\n"
-#define PS_END_LENGTH           (sizeof(PS_END_STRING) - 1)
 #define PS_FILENAME_EXTENSION   ".ps"
 
 using namespace std;
@@ -37,7 +34,9 @@ void ps_writer::init(
 {
     APP_DEBUG_FNAME;
     
-    document_writer::init(filename, PS_FILENAME_EXTENSION);
+    document_writer::init(filename, PS_FILENAME_EXTENSION, PS_END_STRING);
+    // color switched by previous document does not carry over to new one
+    last_used = &RGB::BLACK;
 
     print(get_default_prologue(rna.begin()));
 }
@@ -99,127 +98,111 @@ std::string ps_writer::get_default_prologue() const
     return out.str();
 }
 
-
-/* virtual */ streampos ps_writer::print(
-                                         const std::string& text)
+/* virtual */ void ps_writer::format_circle(
+                                           document_sink& out,
+                                           point centre,
+                                           double radius) const
 {
-    streampos pos = get_pos();
-    
-    fill();
-    
-    print_to_stream(text + PS_END_STRING);
-    seek_from_current_pos(-PS_END_LENGTH);
-    
-    return pos;
-}
-
-/* virtual */ std::string ps_writer::get_circle_formatted(
-                                                          point centre,
-                                                          double radius) const
-{
-    return get_color_formatted(RGB::BLACK) + msprintf("%s %s lwcircle\n", centre, radius);
+    format_color(out, RGB::BLACK);
+    if (centre.bad())
+        out << "0xBADF00D 0xBADF00D " << radius;
+    else
+    {
+        // as point's operator<<, which leaves stream in fixed notation
+        out.put_fixed(centre.x, 2);
+        out << " ";
+        out.put_fixed(centre.y, 2);
+        out << " ";
+        out.put_fixed(radius, 2);
+    }
+    out << " lwcircle\n";
 }
 
-/* virtual */ std::string ps_writer::get_line_formatted(
-                                                        point from,
-                                                        point to,
-                                                        const RGB& color) const
+/* virtual */ void ps_writer::format_line(
+                                         document_sink& out,
+                                         point from,
+                                         point to,
+                                         const RGB& color) const
 {
-
-    return get_line_formatted(from, to, color.get_name());
+    format_line(out, from, to, color.get_name());
 }
 
-/* virtual */ std::string ps_writer::get_line_formatted(
-        point from,
-        point to,
-        const std::string& clazz) const
+/* virtual */ void ps_writer::format_line(
+                                         document_sink& out,
+                                         point from,
+                                         point to,
+                                         const std::string& clazz) const
 {
-    ostringstream out;
-
     if (from.bad() || to.bad())
-        return "";
+        return;
     from = from * get_scaling_ratio();
     to = to * get_scaling_ratio();
-
-    string color_beg, color_end;
-
+    
     out << clazz;
-
-
+    
     for (double coordinates : {from.x , from.y, to.x, to.y})
     {
-        out
-                << std::left
-                << std::setw(PS_COLUMNS_WIDTH)
-                << coordinates;
+        size_t column = out.size();
+        out << coordinates;
+        out.pad(column, PS_COLUMNS_WIDTH);
     }
-    out
-            << " lwline"
-            << endl;
-
-    return out.str();
+    out << " lwline\n";
 }
 
-/* virtual */ std::string ps_writer::get_label_formatted(
-                                                         const rna_label& label,
-                                                         const RGB& color,
-                                                         const label_info li) const
+/* virtual */ void ps_writer::format_label(
+                                          document_sink& out,
+                                          const rna_label& label,
+                                          const RGB& color,
+                                          const label_info& li) const
 {
-    ostringstream out;
-    
-    out
-    << get_color_formatted(color)
-    << get_text_formatted(label.p * get_scaling_ratio(), label.label);
-    
-    return out.str();
+    format_color(out, color);
+    format_text(out, label.p * get_scaling_ratio(), label.label);
 }
 
-/* virtual */ std::string ps_writer::get_label_formatted(
-        const rna_label& label,
-        const std::string& clazz,
-        const label_info li) const
+/* virtual */ void ps_writer::format_label(
+                                          document_sink& out,
+                                          const rna_label& label,
+                                          const std::string& clazz,
+                                          const label_info& li) const
 {
-    ostringstream out;
-
     // TODO: usage of class in PS is not valid and the whole serialization needs to be rewritten to support SVG only,
     // and this is here only so that the code compiles
-    out
-            << clazz
-            << get_text_formatted(label.p * get_scaling_ratio(), label.label);
-
-    return out.str();
+    out << clazz;
+    format_text(out, label.p * get_scaling_ratio(), label.label);
 }
 
-std::string ps_writer::get_text_formatted(
-                                          point p,
-                                          const std::string& text) const
+void ps_writer::format_text(
+                            document_sink& out,
+                            point p,
+                            const std::string& text) const
 {
-    ostringstream out;
-    
-    out
-    << std::left
-    << std::setw(PS_COLUMNS_WIDTH)
-    << ("(" + text + ")")   // full text should have aligned width
-    << " "
-    << std::setw(PS_COLUMNS_WIDTH)
-    << p.x
-    << std::setw(PS_COLUMNS_WIDTH)
-    << p.y
-    << std::setw(PS_COLUMNS_WIDTH)
-    << " lwstring"
-    << endl;
-    
-    return out.str();
+    // every column is left aligned to PS_COLUMNS_WIDTH
+    size_t column = out.size();
+    out << "(" << text << ")";
+    out.pad(column, PS_COLUMNS_WIDTH);
+    out << " ";
+    
+    column = out.size();
+    out << p.x;
+    out.pad(column, PS_COLUMNS_WIDTH);
+    
+    column = out.size();
+    out << p.y;
+    out.pad(column, PS_COLUMNS_WIDTH);
+    
+    column = out.size();
+    out << " lwstring";
+    out.pad(column, PS_COLUMNS_WIDTH);
+    out << "\n";
 }
 
-std::string ps_writer::get_color_formatted(
-                                           const RGB& color) const
+void ps_writer::format_color(
+                             document_sink& out,
+                             const RGB& color) const
 {
     if (color == *last_used)
-        return "";
-    else
-    {
-        last_used = &color;
-        return msprintf("lw%s\n", color.get_name());
-    }
+        return;
+    
+    last_used = &color;
+    out << "lw" << color.get_name() << "\n";
 }
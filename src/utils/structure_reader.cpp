@@ -0,0 +1,595 @@
+/*
+ * File: structure_reader.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <zlib.h>
+
+#include "structure_reader.hpp"
+#include "types.hpp"
+
+// pairs are nested in brackets of first level, pairs crossing them
+// in next levels; tree_base takes next levels as pseudoknots
+#define PAIR_LEVELS         "()[]{}"
+// gaps in aligned sequences of Stockholm
+#define GAP_CHARACTERS      ".-_~"
+// input is read (and decompressed) by blocks of this size
+#define READ_SIZE           (1 << 16)
+
+using namespace std;
+
+namespace
+{
+    /*
+     * parses whole `word` as integer, returns false if it is not one
+     */
+    bool to_int(const string& word, int& value)
+    {
+        if (word.empty())
+            return false;
+
+        char* end;
+        long number = strtol(word.c_str(), &end, 10);
+        value = int(number);
+        return *end == '\0';
+    }
+
+    /*
+     * checks pair table read from file, `pairs` have 1-based partners
+     * from file already converted to 0-based indices
+     */
+    void check_pairs(const vector<int>& pairs, const string& id)
+    {
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            int j = pairs[i];
+            if (j == -1)
+                continue;
+            if (j < 0 || size_t(j) >= pairs.size() || pairs[j] != int(i) || size_t(j) == i)
+                throw wrong_argument_exception("Structure %s: base %s is paired with %s, which is not paired back",
+                                               id, i + 1, j + 1);
+        }
+    }
+}
+
+structure_reader::structure_reader(
+                                   const std::string& _filename,
+                                   format_type _format)
+    : filename(_filename), format(_format)
+{
+    // gzip reads files which are not compressed as they are
+    in = gzopen(filename.c_str(), "rb");
+    if (in == nullptr)
+        throw io_exception("structure_reader(%s) failed, file can not be opened", filename);
+    gzbuffer(in, READ_SIZE);
+
+    if (format == detect)
+        format = detect_format();
+}
+
+structure_reader::structure_reader(
+                                   const std::string& _name,
+                                   const std::string& text,
+                                   format_type _format)
+    : filename(_name), buffer(text), end_of_file(true), format(_format)
+{
+    if (format == detect)
+        format = detect_format();
+}
+
+structure_reader::~structure_reader()
+{
+    if (in != nullptr)
+        gzclose(in);
+}
+
+/* static */ fasta structure_reader::read_text(
+                                               const std::string& text,
+                                               const std::string& name)
+{
+    structure_reader reader(name, text, detect);
+    fasta record;
+
+    if (!reader.next(record))
+        throw wrong_argument_exception("%s does not contain any structure", name);
+    return record;
+}
+
+bool structure_reader::next(
+                            fasta& record)
+{
+    bool read = false;
+
+    switch (format)
+    {
+        case detect:
+        case dot_bracket:
+            read = next_dot_bracket(record);
+            break;
+        case bpseq:
+            read = next_bpseq(record);
+            break;
+        case ct:
+            read = next_ct(record);
+            break;
+        case stockholm:
+            read = next_stockholm(record);
+            break;
+    }
+    if (read)
+    {
+        ++records;
+        DEBUG("%s", to_cstr(record));
+    }
+    return read;
+}
+
+bool structure_reader::next_line(
+                                 line& l)
+{
+    // part of line after `position` already searched for end of line
+    size_t searched = 0;
+    const char* end;
+
+    while (true)
+    {
+        const char* from = buffer.data() + position + searched;
+        end = static_cast<const char*>(memchr(from, '\n', buffer.size() - position - searched));
+        if (end != nullptr)
+            break;
+
+        searched = buffer.size() - position;
+        if (!fill())
+        {
+            if (position == buffer.size())
+                return false;
+            end = buffer.data() + buffer.size();
+            break;
+        }
+    }
+
+    l.begin = buffer.data() + position;
+    l.end = end;
+    position = min(size_t(end - buffer.data()) + 1, buffer.size());
+    if (l.end != l.begin && l.end[-1] == '\r')
+        --l.end;
+
+    return true;
+}
+
+void structure_reader::unread(
+                              const line& l)
+{
+    position = l.begin - buffer.data();
+}
+
+bool structure_reader::fill()
+{
+    if (end_of_file)
+        return false;
+
+    // lines already read are dropped, unless they were read ahead
+    size_t keep = min(position, mark);
+    buffer.erase(0, keep);
+    position -= keep;
+    if (mark != string::npos)
+        mark -= keep;
+
+    size_t size = buffer.size();
+    buffer.resize(size + READ_SIZE);
+    int read = gzread(in, &buffer[size], READ_SIZE);
+    if (read < 0)
+    {
+        int error;
+        throw io_exception("Reading %s failed: %s", filename, gzerror(in, &error));
+    }
+    buffer.resize(size + read);
+
+    end_of_file = read == 0;
+    return !end_of_file;
+}
+
+void structure_reader::split(
+                             const line& l,
+                             std::vector<std::string>& words) const
+{
+    words.clear();
+
+    const char* p = l.begin;
+    while (true)
+    {
+        while (p != l.end && isspace(*p))
+            ++p;
+        if (p == l.end)
+            break;
+
+        const char* word = p;
+        while (p != l.end && !isspace(*p))
+            ++p;
+        words.emplace_back(word, p);
+    }
+}
+
+structure_reader::format_type structure_reader::detect_format()
+{
+    // format is recognized from first lines, reading starts over then;
+    // BPSEQ from CRW has several lines of header
+    mark = position;
+    format_type detected = dot_bracket;
+    vector<string> words;
+    size_t lines = 0;
+    int number;
+    line l;
+
+    while (lines < 10 && next_line(l))
+    {
+        split(l, words);
+        if (words.empty())
+            continue;
+        ++lines;
+
+        if (words[0][0] == '>')
+            break;
+        if (lines == 1 && words.size() > 1 && words[0] == "#" && words[1] == "STOCKHOLM")
+        {
+            detected = stockholm;
+            break;
+        }
+        if (words.size() == 3 && to_int(words[0], number) && to_int(words[2], number))
+        {
+            detected = bpseq;
+            break;
+        }
+        if (lines > 1 && words.size() >= 6 && to_int(words[0], number) && to_int(words[4], number))
+        {
+            detected = ct;
+            break;
+        }
+    }
+
+    position = mark;
+    mark = string::npos;
+    return detected;
+}
+
+std::string structure_reader::get_default_id() const
+{
+    // file name without directory and extension, numbered from second record
+    string id = filename.substr(filename.find_last_of('/') + 1);
+    id = id.substr(0, id.find_last_of('.'));
+    if (records != 0)
+        id += msprintf("_%s", records + 1);
+    return id;
+}
+
+bool structure_reader::next_dot_bracket(
+                                        fasta& record)
+{
+    static const char brackets[] = "[{(.)}]";
+    line l;
+
+    // header '>ID description'
+    const char* p;
+    do
+    {
+        if (!next_line(l))
+            return false;
+        for (p = l.begin; p != l.end && isspace(*p); ++p)
+            ;
+    } while (p == l.end);
+
+    if (*p != '>')
+        throw wrong_argument_exception("starting character of dot-bracket fasta file '>' is missing");
+    record.id = string(p + 1, find(p + 1, l.end, ' '));
+    record.labels.clear();
+    record.brackets.clear();
+
+    // sequence and structure lines up to next header
+    while (true)
+    {
+        if (!next_line(l))
+            break;
+        if (l.begin != l.end && *l.begin == '>')
+        {
+            unread(l);
+            break;
+        }
+
+        if (find_first_of(l.begin, l.end, brackets, brackets + sizeof(brackets) - 1) != l.end)
+            record.brackets.append(l.begin, l.end);
+        else
+            record.labels.append(l.begin, l.end);
+    }
+    return true;
+}
+
+bool structure_reader::next_bpseq(
+                                  fasta& record)
+{
+    // record is optional header followed by lines 'INDEX BASE PARTNER',
+    // it ends with a line which is not a base or when indices start over
+    vector<string> words;
+    vector<int> pairs;
+    string id;
+    int index, partner;
+    line l;
+
+    record.labels.clear();
+    while (true)
+    {
+        if (!next_line(l))
+            break;
+
+        split(l, words);
+        if (words.empty())
+            continue;
+        if (words.size() != 3 || !to_int(words[0], index) || !to_int(words[2], partner))
+        {
+            if (!pairs.empty())
+            {
+                unread(l);
+                break;
+            }
+            // CRW header has 'Filename: NAME.bpseq'
+            if (words[0] == "Filename:" && words.size() > 1)
+                id = words[1].substr(0, words[1].find_last_of('.'));
+            continue;
+        }
+        if (index == 1 && !pairs.empty())
+        {
+            unread(l);
+            break;
+        }
+        if (index != int(pairs.size()) + 1)
+            throw wrong_argument_exception("BPSEQ %s: base %s expected, found %s",
+                                           filename, pairs.size() + 1, index);
+
+        record.labels += words[1][0];
+        pairs.push_back(partner - 1);
+    }
+
+    if (pairs.empty())
+        return false;
+
+    record.id = id.empty() ? get_default_id() : id;
+    check_pairs(pairs, record.id);
+    record.brackets = get_brackets(pairs);
+    return true;
+}
+
+bool structure_reader::next_ct(
+                               fasta& record)
+{
+    // header 'LENGTH [TITLE]' followed by LENGTH lines
+    // 'INDEX BASE PREVIOUS NEXT PARTNER NUMBER'
+    vector<string> words;
+    vector<int> pairs;
+    int length, index, partner;
+    line l;
+
+    do
+    {
+        if (!next_line(l))
+            return false;
+        split(l, words);
+    } while (words.empty() || words[0][0] == '#');
+
+    if (!to_int(words[0], length) || length < 0)
+        throw wrong_argument_exception("CT %s: number of bases expected in header '%s'", filename, l.str());
+
+    record.id = words.size() > 1 ? words.back() : get_default_id();
+    record.labels.clear();
+    while (int(pairs.size()) != length)
+    {
+        if (!next_line(l))
+            throw wrong_argument_exception("CT %s: structure %s has %s bases, %s expected",
+                                           filename, record.id, pairs.size(), length);
+        split(l, words);
+        if (words.empty())
+            continue;
+        if (words.size() < 6 || !to_int(words[0], index) || !to_int(words[4], partner) ||
+            index != int(pairs.size()) + 1)
+            throw wrong_argument_exception("CT %s: base %s expected, found '%s'",
+                                           filename, pairs.size() + 1, l.str());
+
+        record.labels += words[1][0];
+        pairs.push_back(partner - 1);
+    }
+
+    check_pairs(pairs, record.id);
+    record.brackets = get_brackets(pairs);
+    return true;
+}
+
+bool structure_reader::next_stockholm(
+                                      fasta& record)
+{
+    // sequences of alignment are returned one by one,
+    // next alignment is read when all were returned
+    while (aligned == alignment.size())
+    {
+        alignment.clear();
+        aligned = 0;
+        if (!read_alignment())
+            return false;
+    }
+
+    record = move(alignment[aligned++]);
+    return true;
+}
+
+bool structure_reader::read_alignment()
+{
+    vector<string> names;
+    map<string, string> sequences, structures;
+    string consensus;
+    vector<string> words;
+    bool ended = false;
+    line l;
+
+    while (next_line(l))
+    {
+        split(l, words);
+        if (words.empty())
+            continue;
+
+        if (words[0] == "//")
+        {
+            ended = true;
+            break;
+        }
+        if (words[0] == "#=GC" && words.size() == 3 && words[1] == "SS_cons")
+            consensus += words[2];
+        else if (words[0] == "#=GR" && words.size() == 4 && words[2] == "SS")
+            structures[words[1]] += words[3];
+        else if (words[0][0] == '#')
+            continue;
+        else if (words.size() == 2)
+        {
+            // sequences can be interleaved in blocks
+            if (sequences.find(words[0]) == sequences.end())
+                names.push_back(words[0]);
+            sequences[words[0]] += words[1];
+        }
+        else
+            throw wrong_argument_exception("Stockholm %s: unexpected line '%s'", filename, l.str());
+    }
+
+    for (const string& name : names)
+    {
+        const string& sequence = sequences[name];
+        auto own = structures.find(name);
+        const string& structure = own != structures.end() ? own->second : consensus;
+        if (structure.size() != sequence.size())
+            throw wrong_argument_exception("Stockholm %s: structure of %s does not match its alignment",
+                                           filename, name);
+
+        // gap columns are removed, their partners become unpaired
+        vector<int> aligned_pairs = get_wuss_pairs(structure);
+        vector<int> column_base(sequence.size(), -1);
+        fasta f;
+        f.id = name;
+        for (size_t c = 0; c < sequence.size(); ++c)
+        {
+            if (strchr(GAP_CHARACTERS, sequence[c]) != nullptr)
+                continue;
+            column_base[c] = int(f.labels.size());
+            f.labels += sequence[c];
+        }
+
+        vector<int> pairs(f.labels.size(), -1);
+        for (size_t c = 0; c < sequence.size(); ++c)
+            if (column_base[c] != -1 && aligned_pairs[c] != -1 && column_base[aligned_pairs[c]] != -1)
+                pairs[column_base[c]] = column_base[aligned_pairs[c]];
+
+        f.brackets = get_brackets(pairs);
+        alignment.push_back(move(f));
+    }
+
+    return ended || !names.empty();
+}
+
+/* static */ std::vector<int> structure_reader::get_wuss_pairs(
+                                                              const std::string& structure)
+{
+    // bracket pairs of all types and pseudoknots as pairs
+    // of uppercase and lowercase letter, everything else is unpaired
+    static const string opening = "<([{";
+    static const string closing = ">)]}";
+
+    vector<int> pairs(structure.size(), -1);
+    map<char, vector<int>> opened;
+
+    for (size_t i = 0; i < structure.size(); ++i)
+    {
+        char ch = structure[i];
+        size_t type;
+
+        if (opening.find(ch) != string::npos || isupper(static_cast<unsigned char>(ch)))
+            opened[ch].push_back(int(i));
+        else if ((type = closing.find(ch)) != string::npos || islower(static_cast<unsigned char>(ch)))
+        {
+            char open = type != string::npos ? opening[type] : char(toupper(ch));
+            vector<int>& stack = opened[open];
+            if (stack.empty())
+                throw wrong_argument_exception("Structure has unpaired '%s' at position %s", ch, i + 1);
+
+            pairs[i] = stack.back();
+            pairs[stack.back()] = int(i);
+            stack.pop_back();
+        }
+    }
+    for (const auto& o : opened)
+        if (!o.second.empty())
+            throw wrong_argument_exception("Structure has unpaired '%s' at position %s", o.first, o.second.back() + 1);
+
+    return pairs;
+}
+
+/* static */ std::string structure_reader::get_brackets(
+                                                       const std::vector<int>& pairs)
+{
+    static const char levels[] = PAIR_LEVELS;
+    const size_t level_count = (sizeof(levels) - 1) / 2;
+
+    string brackets(pairs.size(), '.');
+    // closing positions of pairs opened in each level, innermost last
+    vector<vector<int>> opened(level_count);
+    size_t left_out = 0;
+
+    for (int i = 0; i < int(pairs.size()); ++i)
+    {
+        int j = pairs[i];
+        if (j > i)
+        {
+            // first level where pair does not cross any other
+            size_t level = 0;
+            while (level != level_count && !opened[level].empty() && opened[level].back() < j)
+                ++level;
+            if (level == level_count)
+            {
+                ++left_out;
+                continue;
+            }
+            opened[level].push_back(j);
+            brackets[i] = levels[2 * level];
+            brackets[j] = levels[2 * level + 1];
+        }
+        else if (j != -1 && j < i)
+        {
+            for (auto& stack : opened)
+                if (!stack.empty() && stack.back() == i)
+                {
+                    stack.pop_back();
+                    break;
+                }
+        }
+    }
+
+    if (left_out != 0)
+        WARN("%s base pairs cross too many other pairs to be written in dot-bracket, they are left unpaired", left_out);
+
+    return brackets;
+}
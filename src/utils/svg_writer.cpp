@@ -23,7 +23,6 @@
 #include "svg_writer.hpp"
 
 #define SVG_END_STRING          "</svg>\n"
-#define SVG_END_LENGTH          (sizeof(SVG_END_STRING) - 1)
 #define SVG_FILENAME_EXTENSION  ".svg"
 
 
@@ -131,7 +130,7 @@ struct svg_writer::style
                                     const std::string& filename,
                                     rna_tree& rna)
 {
-    document_writer::init(filename, SVG_FILENAME_EXTENSION);
+    document_writer::init(filename, SVG_FILENAME_EXTENSION, SVG_END_STRING);
 
     rna_tree::iterator root = rna.begin();
     
@@ -173,115 +172,92 @@ struct svg_writer::style
 //
 //}
 
-/* virtual */ streampos svg_writer::print(
-                                          const std::string& text)
+
+/* virtual */ void svg_writer::format_circle(
+                                            document_sink& out,
+                                            point centre,
+                                            double radius) const
 {
-    streampos pos = get_pos();
-    
-    fill();
-    
-    print_to_stream(text);
-    
-    print_to_stream(SVG_END_STRING);
-    
-    seek_from_current_pos(-SVG_END_LENGTH);
-    
-    return pos;
+    out << "<g><circle ";
+    format_point(out, centre, "c", "");
+    // radius was always written by std::to_string, ie. %f
+    out << "r=\"";
+    out.put_fixed(radius, 6);
+    out << "\" /></g>\n";
 }
 
-
-/* virtual */ std::string svg_writer::get_circle_formatted(
-                                                           point centre,
-                                                           double radius) const
+/* virtual */ void svg_writer::format_label(
+                                           document_sink& out,
+                                           const rna_label& label,
+                                           const RGB& color,
+                                           const label_info& li) const
 {
-    properties out;
-    
-    out
-    << get_point_formatted(centre, "c", "")
-    << property("r", radius);
-    
-    return create_element("circle", out);
+    format_label(out, label, color.get_name(), li);
 }
 
-/* virtual */ std::string svg_writer::get_label_formatted(
-                                                          const rna_label& label,
-                                                          const RGB& color,
-                                                          const label_info li) const
+/* virtual */ void svg_writer::format_label(
+                                           document_sink& out,
+                                           const rna_label& label,
+                                           const std::string& clazz,
+                                           const label_info& li) const
 {
-    return get_label_formatted(label, color.get_name(), li);
-//    properties out;
-//
-//    out
-//    << get_point_formatted(label.p, "", "")
-////    << property("text-anchor", "middle")
-////    << property("baseline-shift", "-50%")
-//    << property("class", color.get_name());
-//
-//    return create_element("text", out, label.label, li);
+    out << "<g>";
+    format_title(out, li);
+    out << "<text ";
+    format_point(out, label.p, "", "");
+    out << "class=\"" << clazz << "\" ";
+    if (label.label.empty())
+        out << "/></g>\n";
+    else
+        out << ">" << label.label << "</text></g>\n";
 }
 
-/* virtual */ std::string svg_writer::get_label_formatted(
-        const rna_label& label,
-        const std::string& clazz,
-        const label_info li) const
+/* virtual */ void svg_writer::format_line(
+                                          document_sink& out,
+                                          point from,
+                                          point to,
+                                          const RGB& color) const
 {
-    properties out;
-
-    out
-            << get_point_formatted(label.p, "", "")
-            //    << property("text-anchor", "middle")
-            //    << property("baseline-shift", "-50%")
-            << property("class", clazz);
-
-    return create_element("text", out, label.label, li);
+    format_line(out, from, to, color.get_name());
 }
 
-
-/* virtual */ std::string svg_writer::get_line_formatted(
-                                                         point from,
-                                                         point to,
-                                                         const RGB& color) const
+/* virtual */ void svg_writer::format_line(
+                                          document_sink& out,
+                                          point from,
+                                          point to,
+                                          const std::string& clazz) const
 {
-
-    return get_line_formatted(from, to, color.get_name());
+    out << "<g><line ";
+    format_point(out, from, "", "1");
+    format_point(out, to, "", "2");
+    out << "class=\"" << clazz << "\" /></g>\n";
 }
 
-/* virtual */ std::string svg_writer::get_line_formatted(
-        point from,
-        point to,
-        const std::string& clazz) const
+void svg_writer::format_point(
+                              document_sink& out,
+                              point p,
+                              const char* prefix,
+                              const char* postfix) const
 {
-    properties out;
-
+    p = (p - bl) * get_scaling_ratio() + margin/2;
+    p.y = letter.y - p.y;
+    
     out
-            << get_point_formatted(from, "", "1")
-            << get_point_formatted(to, "", "2")
-            << property("class", clazz);
-
-    return create_element("line", out);
+    << prefix << "x" << postfix << "=\"" << p.x << "\" "
+    << prefix << "y" << postfix << "=\"" << p.y << "\" ";
 }
 
-svg_writer::properties svg_writer::get_point_formatted(
-                                                       point p,
-                                                       const std::string& prefix,
-                                                       const std::string& postfix,
-                                                       bool should_shift_p) const
+void svg_writer::format_title(
+                              document_sink& out,
+                              const label_info& li) const
 {
-    properties out;
-    
-    if (should_shift_p)
-    {
-        //cale_point(p);
-        p = (p - bl) * get_scaling_ratio() + margin/2;
-        p.y = letter.y - p.y;
-//        p += shift;
-    }
-    
-    out
-    << property(msprintf("%sx%s", prefix, postfix), msprintf("%f", p.x))
-    << property(msprintf("%sy%s", prefix, postfix), msprintf("%f", p.y));
+    if (li.ix < 0)
+        return;
     
-    return out;
+    out << "<title>" << li.ix;
+    if (li.tmp_ix > 0)
+        out << " (position.label in template: " << li.tmp_ix << "." << li.tmp_label.c_str() << ")";
+    out << "</title>";
 }
 
 //std::string svg_writer::create_element(
@@ -0,0 +1,206 @@
+/*
+ * File: template_bundle.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include "template_bundle.hpp"
+#include "rna_tree.hpp"
+#include "types.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+namespace
+{
+    void put_uint32(string& out, uint32_t value)
+    {
+        for (size_t i = 0; i < 4; ++i)
+            out.push_back(char((value >> (8 * i)) & 0xff));
+    }
+
+    void put_float64(string& out, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        for (size_t i = 0; i < 8; ++i)
+            out.push_back(char((bits >> (8 * i)) & 0xff));
+    }
+
+    /*
+     * bounds are checked once for whole bundle by `load`
+     */
+    uint32_t get_uint32(const char*& p)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < 4; ++i)
+            value |= uint32_t(static_cast<unsigned char>(p[i])) << (8 * i);
+        p += 4;
+        return value;
+    }
+
+    double get_float64(const char*& p)
+    {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 8; ++i)
+            bits |= uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+        p += 8;
+
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // magic, version, N, distances, ends, name length, ends points
+    const size_t header_size = 8 + 4 + 4 + 3 * 8 + 4 + 4 + 4 * 8;
+}
+
+/* static */ void template_bundle::save(
+                                        rna_tree& rna,
+                                        const std::string& filename)
+{
+    APP_DEBUG_FNAME;
+
+    typedef rna_tree::pre_post_order_iterator pre_post_order_iterator;
+
+    string labels;
+    vector<point> points;
+    rna_tree::iterator root = rna.begin();
+    for (rna_tree::sibling_iterator ch = root.begin(); ch != root.end(); ++ch)
+        rna_tree::for_each_in_subtree(ch,
+            [&labels, &points](const pre_post_order_iterator& it)
+            {
+                const rna_label& l = it->at(it.label_index());
+                if (l.label.size() != 1)
+                    throw illegal_state_exception("Template bundle: label '%s' is not a single base", l.label);
+                labels += l.label;
+                points.push_back(l.p);
+            });
+
+    string brackets = rna.get_brackets();
+    string name = rna.name();
+    bool ends = root->paired() && root->at(0).label == "5'" && root->at(1).label == "3'";
+    point five = ends ? root->at(0).p : point();
+    point three = ends ? root->at(1).p : point();
+
+    string out;
+    out.reserve(header_size + points.size() * (8 + 8 + 1 + 1) + name.size());
+    out.append(TEMPLATE_BUNDLE_MAGIC, TEMPLATE_BUNDLE_MAGIC_SIZE);
+    put_uint32(out, TEMPLATE_BUNDLE_VERSION);
+    put_uint32(out, uint32_t(points.size()));
+    put_float64(out, rna.get_pairs_distance());
+    put_float64(out, rna.get_pair_base_distance());
+    put_float64(out, rna.get_loops_bases_distance());
+    put_uint32(out, ends ? 1 : 0);
+    put_uint32(out, uint32_t(name.size()));
+    for (const point& p : {five, three})
+    {
+        put_float64(out, p.x);
+        put_float64(out, p.y);
+    }
+    for (const point& p : points)
+        put_float64(out, p.x);
+    for (const point& p : points)
+        put_float64(out, p.y);
+    out += brackets;
+    out += labels;
+    out += name;
+
+    ofstream file(filename, ios::binary);
+    file.write(out.data(), out.size());
+    file.close();
+    if (!file)
+        throw io_exception("Template bundle %s can not be written", filename);
+}
+
+/* static */ rna_tree template_bundle::load(
+                                            const std::string& filename)
+{
+    APP_DEBUG_FNAME;
+
+    if (!is_bundle(filename))
+        throw illegal_state_exception("Template bundle: %s is not a template bundle", filename);
+
+    mapped_file file(filename);
+    const char* p = file.begin() + TEMPLATE_BUNDLE_MAGIC_SIZE;
+    if (file.size() < header_size)
+        throw illegal_state_exception("Template bundle: unexpected end of %s", filename);
+
+    uint32_t version = get_uint32(p);
+    if (version != TEMPLATE_BUNDLE_VERSION)
+        throw illegal_state_exception("Template bundle: unsupported version %s", version);
+
+    uint32_t residues = get_uint32(p);
+    double pairs_distance = get_float64(p);
+    double pair_base_distance = get_float64(p);
+    double loops_bases_distance = get_float64(p);
+    bool ends = get_uint32(p) != 0;
+    uint32_t name_length = get_uint32(p);
+    point five, three;
+    five.x = get_float64(p);
+    five.y = get_float64(p);
+    three.x = get_float64(p);
+    three.y = get_float64(p);
+
+    // x, y, brackets and labels columns and name follow the header
+    if ((file.size() - header_size) / (8 + 8 + 1 + 1) < residues ||
+        file.size() - header_size - size_t(residues) * (8 + 8 + 1 + 1) != name_length)
+        throw illegal_state_exception("Template bundle: size of %s does not match its header", filename);
+
+    vector<point> points(residues);
+    for (point& pt : points)
+        pt.x = get_float64(p);
+    for (point& pt : points)
+        pt.y = get_float64(p);
+    string brackets(p, residues);
+    p += residues;
+    string labels(p, residues);
+    p += residues;
+    string name(p, name_length);
+
+    rna_tree rna(brackets, labels, name);
+    rna.restore_points(points, pairs_distance, pair_base_distance, loops_bases_distance);
+
+    if (ends)
+    {
+        rna_tree::iterator root = rna.begin();
+        root->at(0).p = five;
+        root->at(0).label = "5'";
+        root->at(1).p = three;
+        root->at(1).label = "3'";
+    }
+
+    return rna;
+}
+
+/* static */ bool template_bundle::is_bundle(
+                                             const std::string& filename)
+{
+    char magic[TEMPLATE_BUNDLE_MAGIC_SIZE];
+
+    ifstream file(filename, ios::binary);
+    return file.read(magic, sizeof(magic)) &&
+        memcmp(magic, TEMPLATE_BUNDLE_MAGIC, sizeof(magic)) == 0;
+}
@@ -1,6 +1,7 @@
-#include <fstream>
 #include "traveler_extractor.hpp"
+#include "xml_scanner.hpp"
 #include "types.hpp"
+#include "utils.hpp"
 
 using namespace std;
 
@@ -9,26 +10,26 @@ void traveler_extractor::extract(const string& filename)
     points.clear();
     labels.clear();
     
-    ifstream in(filename);
-    regex base_line("\\s*<point\\s+x=\"(.+)\"\\s+y=\"(.+)\"\\s+b=\"(.+)\"\\s*/>");
-    string line;
-    smatch match;
+    // bases are <point x=".." y=".." b="BASE"/> elements
+    mapped_file file(filename);
+    xml_scanner xml(file.begin(), file.end());
+    xml_scanner::element e;
     point p;
-    string base;
     
-    while(getline(in, line))
+    while (xml.next(e))
     {
-        if(regex_search(line, match, base_line))
-        {
-            stringstream s;
-            s << match[1] << " " << match[2] << " " << match[3];
-            s >> p.x >> p.y >> base;
-            
-            assert(!s.fail() && s.eof() && base.size() == 1);
-            
-            points.push_back(p);
-            labels.push_back(base[0]);
-        }
+        if (e.name != "point")
+            continue;
+        
+        const xml_scanner::span* x = e.get("x");
+        const xml_scanner::span* y = e.get("y");
+        const xml_scanner::span* b = e.get("b");
+        if (x == nullptr || y == nullptr || b == nullptr ||
+            !x->to_double(p.x) || !y->to_double(p.y) || b->size() != 1)
+            continue;
+        
+        points.push_back(p);
+        labels.push_back(*b->begin);
     }
 
     mirror_y();
@@ -4,60 +4,33 @@ using namespace std;
 
 void traveler_writer::init(const string& filename, rna_tree& rna)
 {
-    document_writer::init(filename, ".xml");
+    document_writer::init(filename, ".xml", "</structure>\n");
+    print("<structure>\n");
 }
 
-streampos traveler_writer::print(const string& text)
+void traveler_writer::format_circle(document_sink&, point, double) const
 {
-    if (text.empty())
-        return -1;
-
-    streampos pos = get_pos();
-    
-    fill();
-    
-    print_to_stream("<structure>\n");
-    print_to_stream(text);
-    print_to_stream("</structure>\n");
-    
-    seek_from_current_pos(sizeof("</structure>\n") -1);
-    
-    return pos;
 }
 
-string traveler_writer::get_circle_formatted(point centre, double radius) const
+void traveler_writer::format_label(document_sink& out, const rna_label& label, const RGB& color, const label_info& li) const
 {
-    return "";
+    format_label(out, label, color.get_name(), li);
 }
 
-string traveler_writer::get_label_formatted(const rna_label& label, const RGB& color, const label_info li) const
+void traveler_writer::format_label(document_sink& out, const rna_label& label, const std::string& clazz, const label_info& li) const
 {
-    return get_label_formatted(label, color.get_name(), li);
+    out << "<point x=\"" << label.p.x << "\" y=\"" << label.p.y << "\" b=\"" << label.label << "\"/>\n";
 }
 
-string traveler_writer::get_label_formatted(const rna_label& label, const std::string& clazz, const label_info li) const
+void traveler_writer::format_line(document_sink& out, point from, point to, const RGB& color) const
 {
-    ostringstream out;
-
-    out << "<point x=\"" << label.p.x << "\" y=\"" << label.p.y << "\" b=\"" << label.label << "\"/>"
-        << endl;
-
-    return out.str();
+    format_line(out, from, to, color.get_name());
 }
 
-string traveler_writer::get_line_formatted(point from, point to, const RGB& color) const
+void traveler_writer::format_line(document_sink& out, point from, point to, const std::string& clazz) const
 {
-    return get_line_formatted(from, to, color.get_name());
-}
-
-string traveler_writer::get_line_formatted(point from, point to, const std::string& clazz) const
-{
-    ostringstream out;
-
-    if (from.bad() || to.bad()) return "";
+    if (from.bad() || to.bad()) return;
 
     out << "<line fromX=\"" << from.x << "\" fromY=\"" << from.y << "\" toX=\"" << to.x << "\" toY=\""
-        << to.y << "\"/>" << endl;
-
-    return out.str();
+        << to.y << "\"/>\n";
 }
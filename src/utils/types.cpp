@@ -54,7 +54,7 @@ logger_end_of_function_priority::~logger_end_of_function_priority()
 }
 
 print_class_BEG_END_name::print_class_BEG_END_name(
-                                                   const std::string& _fname)
+                                                   const char* _fname)
 : fname(_fname)
 {
     TRACE("BEG function: %s", fname);
@@ -62,6 +62,9 @@ print_class_BEG_END_name::print_class_BEG_END_name(
 
 print_class_BEG_END_name::~print_class_BEG_END_name()
 {
+    if (!LOGGER_ENABLED(trace, TRACE))
+        return;
+    
     if (uncaught_exception())
     {
         TRACE("END function: %s -> EXCEPTION", fname);
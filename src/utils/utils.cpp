@@ -21,25 +21,18 @@
 
 
 #include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "utils.hpp"
+#include "structure_reader.hpp"
 #include "mapping.hpp"
 #include "exception.hpp"
 
 using namespace std;
 
-template<typename container_type, typename value_container_type>
-bool contains_one_of(
-                     const container_type& container,
-                     const value_container_type& values)
-{
-    for (const auto& val : values)
-        if (contains(container, val))
-            return true;
-    return false;
-}
-
-
 /* global */ std::string read_file(
                                    const std::string& filename)
 {
@@ -76,53 +69,27 @@ bool contains_one_of(
     if (!exist_file(filename))
         throw io_exception("read_file(%s) failed, file does not exist", filename);
     
-    ifstream in(filename);
-    ostringstream labels, brackets;
-    string id, line;
-    
-    while(true)
-    {
-        char ch;
-        in >> ch;
-        if (in.fail() || ch != '>')
-            throw wrong_argument_exception("starting character of dot-bracket fasta file '>' is missing");
-        
-        getline(in, id);
-        size_t index = id.find_first_of(' ');
-        if (index == string::npos)
-            index = id.length();
-        id = id.substr(0, index);
-        break;
-    }
+    structure_reader reader(filename, structure_reader::dot_bracket);
+    fasta f;
+    if (!reader.next(f))
+        throw wrong_argument_exception("starting character of dot-bracket fasta file '>' is missing");
     
-    while(true)
-    {
-        getline(in, line);
-        if (in.fail())
-            break;
-        if (contains(line, '>'))
-            break;
-        
-      if ( line.size() && line[line.size()-1] == '\r' ) {
-           DEBUG("Removing carriage return\n");
-           line = line.substr( 0, line.size() - 1 );
-        }
+    return f;
+}
 
-        if ( line.size() && line[line.size()-1] == '\n' ) {
-           DEBUG("Removing line feed\n");
-           line = line.substr( 0, line.size() - 1 );
-        }
-        if (contains_one_of(line, "[{(.)}]"))
-            brackets << line;
-        else
-            labels << line;
-    }
-    fasta f;
-    f.id = id;
-    f.brackets = brackets.str();
-    f.labels = labels.str();
+/* global */ fasta read_structure_file(
+                                       const std::string& filename)
+{
+    if (!exist_file(filename))
+        throw io_exception("read_file(%s) failed, file does not exist", filename);
+    
+    structure_reader reader(filename);
+    fasta f, next;
+    if (!reader.next(f))
+        throw wrong_argument_exception("File %s does not contain any structure", filename);
+    if (reader.next(next))
+        WARN("File %s contains more structures, only the first one (%s) is used", filename, f.id);
     
-    DEBUG("%s", to_cstr(f));
     return f;
 }
 
@@ -327,3 +294,37 @@ std::ostream& operator<<(
     
     return out;
 }
+
+mapped_file::mapped_file(
+                         const std::string& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw io_exception("mapped_file(%s) failed, file can not be opened", filename);
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw io_exception("mapped_file(%s) failed, file size is not available", filename);
+    }
+    
+    length = st.st_size;
+    if (length != 0)
+    {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            throw io_exception("mapped_file(%s) failed, file can not be mapped", filename);
+        }
+        data = static_cast<const char*>(p);
+    }
+    close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), length);
+}
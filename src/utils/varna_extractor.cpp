@@ -20,13 +20,12 @@
  */
 
 
-#include <fstream>
+#include <cctype>
 
 #include "varna_extractor.hpp"
+#include "xml_scanner.hpp"
 #include "types.hpp"
-
-#define PROPERTY_BEG_END "['\"]"
-#define property(prop) (msprintf("%s%s%s", PROPERTY_BEG_END, prop, PROPERTY_BEG_END))
+#include "utils.hpp"
 
 using namespace std;
 
@@ -38,39 +37,25 @@ void varna_extractor::extract(
     labels.clear();
     points.clear();
     
-    ifstream in(filename);
-    
-    regex regexp_base_line = create_regex(
-                                          msprintf("^<text.*\\s+x=%s.*\\s+y=%s\\s+.*>%s</text>",
-                                                   property(DOUBLE_REGEX), property(DOUBLE_REGEX), BASE_REGEX));
-    
-    smatch match;
-    string line;
+    // bases are <text x=".." y="..">BASE</text> elements
+    mapped_file file(filename);
+    xml_scanner xml(file.begin(), file.end());
+    xml_scanner::element e;
     point p;
-    string base;
     
-    while(true)
+    while (xml.next(e))
     {
-        getline(in, line);
-        if (in.fail())
-            break;
+        if (e.name != "text" || e.text.size() != 1 || !isalpha(*e.text.begin))
+            continue;
         
-        if (regex_search(line, match, regexp_base_line))
-        {
-            stringstream str;
-            
-            str << match[1] << " " << match[3] << " " << match[5];
-            
-            str
-            >> p.x
-            >> p.y
-            >> base;
-            
-            assert(!str.fail() && str.eof() && base.size() == 1);
-
-            labels.push_back(base[0]);
-            points.push_back(p);
-        }
+        const xml_scanner::span* x = e.get("x");
+        const xml_scanner::span* y = e.get("y");
+        if (x == nullptr || y == nullptr ||
+            !x->to_double(p.x) || !y->to_double(p.y))
+            continue;
+        
+        labels.push_back(*e.text.begin);
+        points.push_back(p);
     }
 
     mirror_y();
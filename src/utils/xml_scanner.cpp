@@ -0,0 +1,271 @@
+/*
+ * File: xml_scanner.cpp
+ *
+ * Copyright (C) 2019 David Hoksza <david.hoksza@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "xml_scanner.hpp"
+
+using namespace std;
+
+namespace
+{
+    inline bool is_space(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f';
+    }
+
+    inline bool is_name_end(char ch)
+    {
+        return is_space(ch) || ch == '=' || ch == '/' || ch == '>';
+    }
+
+    const char* skip_spaces(const char* p, const char* e)
+    {
+        while (p != e && is_space(*p))
+            ++p;
+        return p;
+    }
+
+    /*
+     * returns position after first occurrence of `str` in [p, e) or `e`
+     */
+    const char* skip_after(const char* p, const char* e, const char* str)
+    {
+        size_t length = strlen(str);
+        const char* found = search(p, e, str, str + length);
+        return found == e ? e : found + length;
+    }
+}
+
+
+bool xml_scanner::span::operator==(
+                                   const char* str) const
+{
+    size_t length = strlen(str);
+    return size() == length && memcmp(begin, str, length) == 0;
+}
+
+bool xml_scanner::span::to_double(
+                                  double& value) const
+{
+    // spans are not null-terminated, strtod needs a copy
+    char buffer[64];
+    string copy;
+    const char* str;
+
+    if (size() < sizeof(buffer))
+    {
+        memcpy(buffer, begin, size());
+        buffer[size()] = '\0';
+        str = buffer;
+    }
+    else
+    {
+        copy = this->str();
+        str = copy.c_str();
+    }
+
+    char* number_end;
+    value = strtod(str, &number_end);
+
+    return number_end != str &&
+        skip_spaces(number_end, str + size()) == str + size();
+}
+
+const xml_scanner::span* xml_scanner::element::get(
+                                                   const char* name) const
+{
+    for (const attribute& a : attributes)
+        if (a.name == name)
+            return &a.value;
+    return nullptr;
+}
+
+
+xml_scanner::xml_scanner(
+                         const char* _begin,
+                         const char* _end)
+    : actual(_begin), end(_end)
+{ }
+
+bool xml_scanner::next(
+                       element& e)
+{
+    while (actual != end)
+    {
+        actual = static_cast<const char*>(memchr(actual, '<', end - actual));
+        if (actual == nullptr)
+        {
+            actual = end;
+            break;
+        }
+        if (actual + 1 == end)
+        {
+            actual = end;
+            break;
+        }
+
+        char ch = actual[1];
+        if (ch == '!' || ch == '?' || ch == '/')
+        {
+            actual = skip_markup(actual);
+            continue;
+        }
+
+        const char* p = read_tag(actual, e);
+        if (p == nullptr)
+        {
+            // not a tag, continue after '<'
+            ++actual;
+            continue;
+        }
+
+        actual = p;
+        e.text = span();
+        if (!e.self_closing)
+        {
+            const char* text_end = static_cast<const char*>(memchr(actual, '<', end - actual));
+            if (text_end == nullptr)
+                text_end = end;
+
+            const char* text_begin = skip_spaces(actual, text_end);
+            while (text_end != text_begin && is_space(text_end[-1]))
+                --text_end;
+            e.text.begin = text_begin;
+            e.text.end = text_end;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+const char* xml_scanner::skip_markup(
+                                     const char* p) const
+{
+    static const char comment[] = "<!--";
+    static const char cdata[] = "<![CDATA[";
+
+    size_t left = end - p;
+
+    if (left >= sizeof(comment) - 1 && memcmp(p, comment, sizeof(comment) - 1) == 0)
+        return skip_after(p + sizeof(comment) - 1, end, "-->");
+    if (left >= sizeof(cdata) - 1 && memcmp(p, cdata, sizeof(cdata) - 1) == 0)
+        return skip_after(p + sizeof(cdata) - 1, end, "]]>");
+    if (p[1] == '?')
+        return skip_after(p + 2, end, "?>");
+
+    // end tag or declaration, declaration can contain
+    // quoted strings and internal subset in brackets
+    char quote = 0;
+    int depth = 0;
+    for (++p; p != end; ++p)
+    {
+        if (quote != 0)
+        {
+            if (*p == quote)
+                quote = 0;
+        }
+        else if (*p == '"' || *p == '\'')
+            quote = *p;
+        else if (*p == '[')
+            ++depth;
+        else if (*p == ']')
+            --depth;
+        else if (*p == '>' && depth <= 0)
+            return p + 1;
+    }
+    return end;
+}
+
+const char* xml_scanner::read_tag(
+                                  const char* p,
+                                  element& e) const
+{
+    e.attributes.clear();
+    e.self_closing = false;
+
+    e.name.begin = ++p;
+    while (p != end && !is_name_end(*p))
+        ++p;
+    e.name.end = p;
+    if (e.name.size() == 0)
+        return nullptr;
+
+    while (true)
+    {
+        p = skip_spaces(p, end);
+        if (p == end)
+            return nullptr;
+
+        if (*p == '>')
+            return p + 1;
+        if (*p == '/')
+        {
+            if (p + 1 == end || p[1] != '>')
+                return nullptr;
+            e.self_closing = true;
+            return p + 2;
+        }
+
+        attribute a;
+        a.name.begin = p;
+        while (p != end && !is_name_end(*p))
+            ++p;
+        a.name.end = p;
+        if (a.name.size() == 0)
+            return nullptr;
+
+        p = skip_spaces(p, end);
+        if (p != end && *p == '=')
+        {
+            p = skip_spaces(p + 1, end);
+            if (p == end)
+                return nullptr;
+
+            if (*p == '"' || *p == '\'')
+            {
+                const char* close = static_cast<const char*>(memchr(p + 1, *p, end - p - 1));
+                if (close == nullptr)
+                    return nullptr;
+                a.value.begin = p + 1;
+                a.value.end = close;
+                p = close + 1;
+            }
+            else
+            {
+                // unquoted value
+                a.value.begin = p;
+                while (p != end && !is_space(*p) && *p != '>' &&
+                       !(*p == '/' && p + 1 != end && p[1] == '>'))
+                    ++p;
+                a.value.end = p;
+            }
+        }
+        else
+            a.value.begin = a.value.end = p;
+
+        e.attributes.push_back(a);
+    }
+}
@@ -16,8 +16,7 @@ do
 
     echo "`date`: Working on ${TGT} using ${TMP} as a template"
 
-    ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure ${TMP_DIR}${TMP}.ps ${TMP_DIR}/${TMP}.fasta --ted ${OUT_DIR}${TGT}.map
-    ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure ${TMP_DIR}${TMP}.ps ${TMP_DIR}/${TMP}.fasta --draw ${OUT_DIR}${TGT}.map ${OUT_DIR}/${TGT}
+    ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure ${TMP_DIR}${TMP}.ps ${TMP_DIR}/${TMP}.fasta --ted ${OUT_DIR}${TGT}.map --draw ${OUT_DIR}${TGT}.map ${OUT_DIR}/${TGT}
 done
 
 TGTS=( J01436.1456.1522 )
@@ -30,6 +29,7 @@ do
 
     echo "`date`: Working on ${TGT} using ${TMP} as a template"
 
+    # mapping written by --ted is read back by --draw alone
     ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure --file-format varna ${TMP_DIR}${TMP}.svg ${TMP_DIR}/${TMP}.fasta --ted ${OUT_DIR}${TGT}.map
     ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure --file-format varna ${TMP_DIR}${TMP}.svg ${TMP_DIR}/${TMP}.fasta --draw ${OUT_DIR}${TGT}.map ${OUT_DIR}/${TGT}
 done
@@ -44,6 +44,25 @@ do
 
     echo "`date`: Working on ${TGT} using ${TMP} as a template"
 
-    ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure --file-format traveler ${TMP_DIR}${TMP}.tr ${TMP_DIR}/${TMP}.fasta --ted ${OUT_DIR}${TGT}.map
-    ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure --file-format traveler ${TMP_DIR}${TMP}.tr ${TMP_DIR}/${TMP}.fasta --draw ${OUT_DIR}${TGT}.map ${OUT_DIR}/${TGT}
+    ${TRAVELER_DIR}traveler --target-structure ${TGT_DIR}${TGT}.fasta  --template-structure --file-format traveler ${TMP_DIR}${TMP}.tr ${TMP_DIR}/${TMP}.fasta --ted ${OUT_DIR}${TGT}.map --draw ${OUT_DIR}${TGT}.map ${OUT_DIR}/${TGT}
+done
+
+# batch of the first pairs above with one failing job, the batch fails,
+# other jobs are laid out as by separate runs
+TGTS=( URS00000B9D9D_471852-d.5.b.A.madurae URS00000B14F2_575540-d.5.b.P.brasiliensis )
+
+echo "`date`: Working on batch data/batch.tsv"
+
+if ${TRAVELER_DIR}traveler --batch data/batch.tsv
+then
+    echo "batch with failing job should fail"
+    exit 1
+fi
+
+for TGT in ${TGTS[@]}
+do
+    for EXT in svg colored.svg ps colored.ps xml json
+    do
+        cmp ${OUT_DIR}${TGT}.${EXT} ${OUT_DIR}batch-${TGT}.${EXT} || exit 1
+    done
 done
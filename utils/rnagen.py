@@ -0,0 +1,399 @@
+import sys
+import gzip
+import json
+import math
+import random
+import argparse
+import logging
+
+# weights of paired and unpaired bases
+PAIRS = [("G", "C", 30), ("C", "G", 30), ("A", "U", 15), ("U", "A", 15), ("G", "U", 5), ("U", "G", 5)]
+UNPAIRED = [("A", 35), ("U", 25), ("G", 20), ("C", 20)]
+
+BRACKETS = {'(': ')', '[': ']', '{': '}', '<': '>'}
+
+# structural edits, as in data/operations
+EDITS = ["add_bp", "rm_bp", "add_base", "rm_base"]
+
+
+def error_exit(message):
+    logging.error(message)
+    sys.exit(1)
+
+
+def open_file(file_name, mode="r"):
+    access_type = mode
+    if sys.version_info >= (3,): access_type = mode + "t"
+    if file_name.endswith("gz"):
+        return gzip.open(file_name, access_type)
+    else:
+        return open(file_name, access_type)
+
+
+def parse_range(text):
+    """
+    MIN:MAX or single number
+    """
+    sText = text.split(':')
+    try:
+        low = int(sText[0])
+        high = int(sText[-1])
+    except ValueError:
+        raise argparse.ArgumentTypeError("'{}' is not a range MIN:MAX".format(text))
+    if len(sText) > 2 or low < 0 or high < low:
+        raise argparse.ArgumentTypeError("'{}' is not a range MIN:MAX".format(text))
+    return [low, high]
+
+
+def read_fasta(f):
+    """
+    returns [name, sequence, structure] of dot-bracket fasta
+    """
+    lines = [line.strip() for line in f if line.strip() != ""]
+    if len(lines) < 3 or not lines[0].startswith('>'):
+        error_exit("Input is not a dot-bracket fasta with name, sequence and structure")
+    name = lines[0][1:].strip()
+    # sequence and structure can span more lines, both have the same length
+    body = lines[1:]
+    half = len(body) // 2
+    seq = "".join(body[:half])
+    struct = "".join(body[half:])
+    if len(seq) != len(struct):
+        error_exit("Sequence and structure of {} have different lengths".format(name))
+    return [name, seq, struct]
+
+
+def short_name(name):
+    """
+    first word of fasta name
+    """
+    return (name.split() + ["rna"])[0]
+
+
+def write_fasta(f, name, seq, struct):
+    f.write('>{}\n'.format(name))
+    f.write('{}\n'.format(seq))
+    f.write('{}\n'.format(struct))
+
+
+def get_pairs(struct):
+    """
+    returns partner of every position or -1
+    """
+    partner = [-1] * len(struct)
+    stacks = dict((b, []) for b in BRACKETS)
+    closing = dict((v, k) for k, v in BRACKETS.items())
+    for i, ch in enumerate(struct):
+        if ch in BRACKETS:
+            stacks[ch].append(i)
+        elif ch in closing:
+            if not stacks[closing[ch]]:
+                error_exit("Unbalanced structure at position {}".format(i))
+            j = stacks[closing[ch]].pop()
+            partner[i] = j
+            partner[j] = i
+    return partner
+
+
+class Generator:
+    """
+    random secondary structures built from helices and loops
+    """
+    def __init__(self, rnd, stem, hairpin, linker, branch):
+        self.rnd = rnd
+        self.stem = stem
+        self.hairpin = hairpin
+        self.linker = linker
+        self.branch = branch
+        # smallest helix closing a hairpin
+        self.min_helix = 2 * max(1, stem[0]) + max(3, hairpin[0])
+
+    def draw(self, bounds):
+        return self.rnd.randint(bounds[0], bounds[1])
+
+    def pair(self):
+        return self.choose(PAIRS)
+
+    def base(self):
+        return self.choose(UNPAIRED)[0]
+
+    def choose(self, weighted):
+        total = sum(w[-1] for w in weighted)
+        x = self.rnd.uniform(0, total)
+        for w in weighted:
+            x -= w[-1]
+            if x <= 0:
+                return w
+        return weighted[-1]
+
+    def branches(self, n, closed):
+        """
+        number of helices in loop of `n` residues
+        """
+        k = 1
+        if not closed or self.rnd.random() < self.branch:
+            # multiloop or exterior loop, geometric number of helices
+            k = 2 if closed else 1
+            while self.rnd.random() < self.branch:
+                k += 1
+        return max(1, min(k, n // (self.min_helix + self.linker[1])))
+
+    def loop(self, n, closed, out):
+        """
+        appends loop of `n` residues to `out`, closed by base pair or exterior
+        """
+        # hairpin, or too small to contain helix
+        if n < self.min_helix + (1 if closed else 0) or (closed and n <= self.hairpin[1] and self.rnd.random() > self.branch):
+            out.extend('.' * n)
+            return
+
+        k = self.branches(n, closed)
+        linkers = [self.draw(self.linker) for _ in range(k + 1)]
+        # stems of interior loop do not stack directly
+        if closed and sum(linkers) == 0:
+            linkers[self.rnd.randint(0, k)] = 1
+        while sum(linkers) + k * self.min_helix > n:
+            linkers[linkers.index(max(linkers))] -= 1
+        free = n - sum(linkers) - k * self.min_helix
+
+        # residues left are split among helices at random cuts
+        cuts = sorted(self.rnd.randint(0, free) for _ in range(k - 1))
+        sizes = [b - a + self.min_helix for a, b in zip([0] + cuts, cuts + [free])]
+
+        for i in range(k):
+            out.extend('.' * linkers[i])
+            self.helix(sizes[i], out)
+        out.extend('.' * linkers[k])
+
+    def helix(self, n, out):
+        """
+        appends helix of `n` residues including its loops to `out`
+        """
+        s = min(self.draw(self.stem), (n - max(3, self.hairpin[0])) // 2)
+        s = max(1, s)
+        out.extend('(' * s)
+        self.loop(n - 2 * s, True, out)
+        out.extend(')' * s)
+
+    def structure(self, n):
+        out = []
+        self.loop(n, False, out)
+        return ''.join(out)
+
+    def sequence(self, struct):
+        seq = [''] * len(struct)
+        partner = get_pairs(struct)
+        for i, j in enumerate(partner):
+            if j == -1:
+                seq[i] = self.base()
+            elif i < j:
+                p = self.pair()
+                seq[i] = p[0]
+                seq[j] = p[1]
+        return ''.join(seq)
+
+
+def edit(gen, seq, struct, count):
+    """
+    applies `count` random edits to structure and sequence
+    """
+    seq = list(seq)
+    struct = list(struct)
+    done = dict((e, 0) for e in EDITS)
+    attempts = 0
+
+    while sum(done.values()) < count and attempts < 100 * (count + 1):
+        attempts += 1
+        operation = gen.rnd.choice(EDITS)
+        partner = get_pairs(struct)
+        paired = [i for i, j in enumerate(partner) if i < j]
+        unpaired = [i for i, j in enumerate(partner) if j == -1]
+
+        if operation == "add_bp" and paired:
+            # new pair closes existing one, stem gets longer
+            i = gen.rnd.choice(paired)
+            j = partner[i]
+            p = gen.pair()
+            seq.insert(j + 1, p[1])
+            struct.insert(j + 1, BRACKETS[struct[i]])
+            seq.insert(i, p[0])
+            struct.insert(i, struct[i])
+        elif operation == "rm_bp" and paired:
+            i = gen.rnd.choice(paired)
+            j = partner[i]
+            del seq[j], struct[j]
+            del seq[i], struct[i]
+        elif operation == "add_base":
+            i = gen.rnd.randint(0, len(struct))
+            seq.insert(i, gen.base())
+            struct.insert(i, '.')
+        elif operation == "rm_base" and unpaired:
+            i = gen.rnd.choice(unpaired)
+            del seq[i], struct[i]
+        else:
+            continue
+        done[operation] += 1
+
+    logging.info("Edits: {}".format(", ".join("{} {}".format(e, done[e]) for e in EDITS)))
+    return [''.join(seq), ''.join(struct)]
+
+
+def concat(inputs, gap):
+    """
+    joins structures with their layouts, copies are placed on a grid
+    """
+    columns = int(math.ceil(math.sqrt(len(inputs))))
+    names = []
+    bases = ""
+    seq = ""
+    struct = ""
+    xs = []
+    ys = []
+    x0 = 0
+    y0 = 0
+    row_height = 0
+
+    for n, (fasta, layout) in enumerate(inputs):
+        if n % columns == 0 and n != 0:
+            x0 = 0
+            y0 += row_height + gap
+            row_height = 0
+        if any(len(layout[key]) != len(fasta[1]) for key in ["x", "y", "base"]):
+            error_exit("Layout of {} does not match its structure".format(fasta[0]))
+
+        minx = min(layout["x"])
+        miny = min(layout["y"])
+        xs += [x - minx + x0 for x in layout["x"]]
+        ys += [y - miny + y0 for y in layout["y"]]
+        x0 += max(layout["x"]) - minx + gap
+        row_height = max(row_height, max(layout["y"]) - miny)
+
+        if short_name(fasta[0]) not in names:
+            names.append(short_name(fasta[0]))
+        bases += layout["base"]
+        seq += fasta[1]
+        struct += fasta[2]
+
+    return ["+".join(names), seq, struct, {"name": "", "residues": len(bases), "x": xs, "y": ys, "base": bases}]
+
+
+def main():
+    rnd = random.Random(args.seed)
+    gen = Generator(rnd, args.stem, args.hairpin, args.linker, args.branch)
+
+    if args.mode == "random":
+        struct = gen.structure(args.length)
+        seq = gen.sequence(struct)
+        name = args.name or "random_{}_seed_{}".format(args.length, args.seed)
+    elif args.mode == "edit":
+        with open_file(args.input[0], "r") as fr:
+            name, seq, struct = read_fasta(fr)
+        seq, struct = edit(gen, seq, struct, int(round(args.edit_rate * len(struct))))
+        name = args.name or "{}_edited_{}_seed_{}".format(short_name(name), args.edit_rate, args.seed)
+    else:
+        inputs = []
+        for i in range(args.copies):
+            for fasta_file, layout_file in args.input:
+                with open_file(fasta_file, "r") as fr:
+                    fasta = read_fasta(fr)
+                with open_file(layout_file, "r") as fr:
+                    layout = json.load(fr)
+                inputs.append([fasta, layout])
+        name, seq, struct, layout = concat(inputs, args.gap)
+        name = args.name or "{}_x{}".format(name, args.copies)
+        with open_file(args.layout_output, "w") as fw:
+            json.dump(layout, fw, separators=(',', ':'))
+            fw.write('\n')
+
+    with (sys.stdout if args.output is None else open_file(args.output, "w")) as fw:
+        write_fasta(fw, name, seq, struct)
+    logging.info("{}: {} nt, {} bp".format(name, len(struct), sum(1 for p in get_pairs(struct) if p != -1) // 2))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description="Generates large structures for scaling tests: random structures, "
+                    "structures derived by random edits and concatenated templates with their layouts.")
+
+    parser.add_argument("mode",
+                        choices=["random", "edit", "concat"],
+                        help="random: new structure of --length residues; "
+                             "edit: --input fasta changed by --edit-rate edits; "
+                             "concat: --input fasta and layout pairs joined, --copies times")
+    parser.add_argument("-i", "--input",
+                        metavar='FILE',
+                        nargs='+',
+                        help="Dot-bracket fasta for edit mode; for concat mode fasta and its json layout "
+                             "(as written by traveler --all), more pairs can follow.")
+    parser.add_argument("-o", "--output",
+                        metavar='FILE',
+                        help="Output file name for the FASTA file. "
+                             "If non entered, the standard output will be used.")
+    parser.add_argument("--layout-output",
+                        metavar='FILE',
+                        help="Output file name for the json layout of concat mode, "
+                             "usable as template with --file-format layout.")
+    parser.add_argument("-n", "--name",
+                        help="Name of the generated structure.")
+    parser.add_argument("-s", "--seed",
+                        type=int,
+                        default=0,
+                        help="Seed of the random generator, the same seed gives the same output.")
+    parser.add_argument("-l", "--length",
+                        type=int,
+                        default=10000,
+                        help="Length of random structure.")
+    parser.add_argument("--stem",
+                        type=parse_range,
+                        default="3:10",
+                        metavar='MIN:MAX',
+                        help="Base pairs of a helix between two loops.")
+    parser.add_argument("--hairpin",
+                        type=parse_range,
+                        default="3:8",
+                        metavar='MIN:MAX',
+                        help="Unpaired residues of a hairpin loop.")
+    parser.add_argument("--linker",
+                        type=parse_range,
+                        default="0:6",
+                        metavar='MIN:MAX',
+                        help="Unpaired residues between helices of interior, multibranch and exterior loops.")
+    parser.add_argument("--branch",
+                        type=float,
+                        default=0.3,
+                        help="Probability that a loop branches into one more helix.")
+    parser.add_argument("-e", "--edit-rate",
+                        type=float,
+                        default=0.01,
+                        help="Edits (added or removed base pairs and residues) per residue in edit mode.")
+    parser.add_argument("-c", "--copies",
+                        type=int,
+                        default=1,
+                        help="Copies of inputs joined in concat mode.")
+    parser.add_argument("--gap",
+                        type=float,
+                        default=100,
+                        help="Space between concatenated layouts.")
+
+    args = parser.parse_args()
+
+    logging.basicConfig(
+        level=logging.DEBUG,
+        format='%(asctime)s [%(levelname)s] %(module)s - %(message)s',
+        datefmt='%H:%M:%S')
+
+    if args.mode != "random" and not args.input:
+        error_exit("Mode {} needs --input".format(args.mode))
+    if args.mode == "edit" and len(args.input) != 1:
+        error_exit("Mode edit takes one fasta")
+    if args.mode == "concat":
+        if len(args.input) % 2 != 0:
+            error_exit("Mode concat takes pairs of fasta and layout")
+        if args.layout_output is None:
+            error_exit("Mode concat needs --layout-output")
+        args.input = list(zip(args.input[0::2], args.input[1::2]))
+    if args.length < 1 or args.copies < 1 or not 0 <= args.branch < 1 or args.edit_rate < 0:
+        error_exit("Length, copies, branch probability or edit rate out of range")
+
+    sys.setrecursionlimit(max(10000, 4 * args.length))
+    main()